@@ -0,0 +1,250 @@
+#pragma once
+
+#include <vector>
+
+#include <nodes/NodeDataModel>
+
+using QtNodes::PortType;
+using QtNodes::PortIndex;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+using QtNodes::NodeDataModel;
+
+/// Minimal payload used by the benchmark models.
+class BenchData : public NodeData
+{
+public:
+
+  BenchData(double value = 0.0)
+    : _value(value)
+  {}
+
+  NodeDataType
+  type() const override
+  {
+    //       id      name
+    return {"bench", "Value"};
+  }
+
+  double
+  value() const { return _value; }
+
+private:
+
+  double _value;
+};
+
+
+/// No inputs, one output carrying a constant value.
+class BenchSourceModel : public NodeDataModel
+{
+public:
+
+  QString
+  caption() const override
+  { return QStringLiteral("Bench Source"); }
+
+  QString
+  name() const override
+  { return QStringLiteral("BenchSource"); }
+
+  std::unique_ptr<NodeDataModel>
+  clone() const override
+  { return std::make_unique<BenchSourceModel>(); }
+
+  unsigned int
+  nPorts(PortType portType) const override
+  { return portType == PortType::Out ? 1 : 0; }
+
+  NodeDataType
+  dataType(PortType, PortIndex) const override
+  { return QtNodes::dataTypeOf<BenchData>(); }
+
+  void
+  setInData(std::shared_ptr<NodeData>, PortIndex) override
+  {}
+
+  std::shared_ptr<NodeData>
+  outData(PortIndex) override
+  { return _data; }
+
+  QWidget *
+  embeddedWidget() override { return nullptr; }
+
+private:
+
+  std::shared_ptr<BenchData> _data = std::make_shared<BenchData>(1.0);
+};
+
+
+/// One input forwarded unchanged to one output.
+class BenchPassThroughModel : public NodeDataModel
+{
+public:
+
+  QString
+  caption() const override
+  { return QStringLiteral("Bench Pass"); }
+
+  QString
+  name() const override
+  { return QStringLiteral("BenchPassThrough"); }
+
+  std::unique_ptr<NodeDataModel>
+  clone() const override
+  { return std::make_unique<BenchPassThroughModel>(); }
+
+  unsigned int
+  nPorts(PortType) const override
+  { return 1; }
+
+  NodeDataType
+  dataType(PortType, PortIndex) const override
+  { return QtNodes::dataTypeOf<BenchData>(); }
+
+  void
+  setInData(std::shared_ptr<NodeData> data, PortIndex) override
+  {
+    ++evaluations();
+
+    _data = data;
+
+    emit dataUpdated(0);
+  }
+
+  /// setInData calls on every instance so far.
+  static int &
+  evaluations()
+  {
+    static int count = 0;
+    return count;
+  }
+
+  std::shared_ptr<NodeData>
+  outData(PortIndex) override
+  { return _data; }
+
+  QWidget *
+  embeddedWidget() override { return nullptr; }
+
+private:
+
+  std::shared_ptr<NodeData> _data;
+};
+
+
+/// Two inputs summed into one output.
+class BenchMergeModel : public NodeDataModel
+{
+public:
+
+  QString
+  caption() const override
+  { return QStringLiteral("Bench Merge"); }
+
+  QString
+  name() const override
+  { return QStringLiteral("BenchMerge"); }
+
+  std::unique_ptr<NodeDataModel>
+  clone() const override
+  { return std::make_unique<BenchMergeModel>(); }
+
+  unsigned int
+  nPorts(PortType portType) const override
+  { return portType == PortType::In ? 2 : 1; }
+
+  NodeDataType
+  dataType(PortType, PortIndex) const override
+  { return QtNodes::dataTypeOf<BenchData>(); }
+
+  void
+  setInData(std::shared_ptr<NodeData> data, PortIndex portIndex) override
+  {
+    _inputs[portIndex] = std::static_pointer_cast<BenchData>(data);
+
+    double sum = 0.0;
+    for (auto const &input : _inputs)
+    {
+      if (input)
+        sum += input->value();
+    }
+
+    _result = std::make_shared<BenchData>(sum);
+
+    emit dataUpdated(0);
+  }
+
+  std::shared_ptr<NodeData>
+  outData(PortIndex) override
+  { return _result; }
+
+  QWidget *
+  embeddedWidget() override { return nullptr; }
+
+private:
+
+  std::shared_ptr<BenchData> _inputs[2];
+
+  std::shared_ptr<BenchData> _result;
+};
+
+
+/// Any number of inputs, added and removed one at a time.
+class BenchVariadicModel : public NodeDataModel
+{
+public:
+
+  QString
+  caption() const override
+  { return QStringLiteral("Bench Variadic"); }
+
+  QString
+  name() const override
+  { return QStringLiteral("BenchVariadic"); }
+
+  std::unique_ptr<NodeDataModel>
+  clone() const override
+  { return std::make_unique<BenchVariadicModel>(); }
+
+  unsigned int
+  nPorts(PortType portType) const override
+  { return portType == PortType::In ? static_cast<unsigned int>(_inputs.size()) : 1; }
+
+  NodeDataType
+  dataType(PortType, PortIndex) const override
+  { return QtNodes::dataTypeOf<BenchData>(); }
+
+  void
+  insertInput(PortIndex index)
+  {
+    _inputs.insert(_inputs.begin() + index, nullptr);
+
+    emit portInserted(PortType::In, index);
+  }
+
+  void
+  removeInput(PortIndex index)
+  {
+    emit portAboutToBeRemoved(PortType::In, index);
+
+    _inputs.erase(_inputs.begin() + index);
+
+    emit portRemoved(PortType::In, index);
+  }
+
+  void
+  setInData(std::shared_ptr<NodeData> data, PortIndex portIndex) override
+  { _inputs[portIndex] = data; }
+
+  std::shared_ptr<NodeData>
+  outData(PortIndex) override
+  { return nullptr; }
+
+  QWidget *
+  embeddedWidget() override { return nullptr; }
+
+private:
+
+  std::vector<std::shared_ptr<NodeData>> _inputs;
+};
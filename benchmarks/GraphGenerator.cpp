@@ -0,0 +1,383 @@
+#include "GraphGenerator.hpp"
+
+#include <algorithm>
+#include <random>
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QUuid>
+
+#include <nodes/internal/Group.hpp>
+
+#include "BenchmarkModels.hpp"
+
+using QtNodes::DataModelRegistry;
+using QtNodes::FlowScene;
+using QtNodes::Group;
+using QtNodes::Node;
+using QtNodes::PortIndex;
+
+namespace
+{
+
+QString const sourceModel  = QStringLiteral("BenchSource");
+QString const passModel    = QStringLiteral("BenchPassThrough");
+QString const mergeModel   = QStringLiteral("BenchMerge");
+
+// Distance between neighbouring nodes, large enough for the bench models
+qreal const nodeSpacingX = 200.0;
+qreal const nodeSpacingY = 150.0;
+
+// Free space between a group border and the nodes it contains
+qreal const groupMargin = 50.0;
+
+}
+
+
+std::shared_ptr<DataModelRegistry>
+GraphGenerator::
+registry()
+{
+  auto ret = std::make_shared<DataModelRegistry>();
+
+  ret->registerModel<BenchSourceModel>("Bench");
+  ret->registerModel<BenchPassThroughModel>("Bench");
+  ret->registerModel<BenchMergeModel>("Bench");
+  ret->registerModel<BenchVariadicModel>("Bench");
+
+  return ret;
+}
+
+
+GraphGenerator
+GraphGenerator::
+chain(int count)
+{
+  GraphGenerator ret;
+  ret._nodes.reserve(count);
+
+  for (int i = 0; i < count; ++i)
+  {
+    int node = ret.addNode(i == 0 ? sourceModel : passModel, gridPosition(i));
+
+    if (i > 0)
+      ret.connect(node - 1, node);
+  }
+
+  return ret;
+}
+
+
+GraphGenerator
+GraphGenerator::
+fanOut(int width)
+{
+  GraphGenerator ret;
+  ret._nodes.reserve(width + 1);
+
+  int const source = ret.addNode(sourceModel, QPointF(0.0, 0.0));
+
+  for (int i = 0; i < width; ++i)
+  {
+    QPointF const position = gridPosition(i) + QPointF(nodeSpacingX, 0.0);
+
+    ret.connect(source, ret.addNode(passModel, position));
+  }
+
+  return ret;
+}
+
+
+GraphGenerator
+GraphGenerator::
+diamonds(int count)
+{
+  GraphGenerator ret;
+  ret._nodes.reserve(3 * count + 1);
+
+  int tip = ret.addNode(sourceModel, QPointF(0.0, 0.0));
+
+  for (int i = 0; i < count; ++i)
+  {
+    // Diamonds are two columns wide, wrap every 50 of them
+    qreal const x = (2 * (i % 50) + 1) * nodeSpacingX;
+    qreal const y = (i / 50) * 3 * nodeSpacingY;
+
+    int const upper = ret.addNode(passModel,  QPointF(x, y));
+    int const lower = ret.addNode(passModel,  QPointF(x, y + nodeSpacingY));
+    int const merge = ret.addNode(mergeModel, QPointF(x + nodeSpacingX, y + nodeSpacingY / 2));
+
+    ret.connect(tip, upper);
+    ret.connect(tip, lower);
+    ret.connect(upper, merge, 0);
+    ret.connect(lower, merge, 1);
+
+    tip = merge;
+  }
+
+  return ret;
+}
+
+
+GraphGenerator
+GraphGenerator::
+grid(int rows, int columns)
+{
+  GraphGenerator ret;
+  ret._nodes.reserve(rows * columns);
+
+  for (int row = 0; row < rows; ++row)
+  {
+    for (int column = 0; column < columns; ++column)
+    {
+      QPointF const position(column * nodeSpacingX, row * nodeSpacingY);
+
+      bool const first = (row == 0 && column == 0);
+
+      int const node = ret.addNode(first ? sourceModel : mergeModel, position);
+
+      if (row > 0)
+        ret.connect(node - columns, node, 0);
+
+      if (column > 0)
+        ret.connect(node - 1, node, 1);
+    }
+  }
+
+  return ret;
+}
+
+
+GraphGenerator
+GraphGenerator::
+groupedChains(int groups, int nodesPerGroup)
+{
+  GraphGenerator ret;
+  ret._nodes.reserve(groups * nodesPerGroup);
+  ret._groups.reserve(groups);
+
+  qreal const rowHeight = nodeSpacingY + 4 * groupMargin;
+
+  int last = -1;
+
+  for (int g = 0; g < groups; ++g)
+  {
+    qreal const y = g * rowHeight;
+
+    for (int i = 0; i < nodesPerGroup; ++i)
+    {
+      QString const &model = (last < 0) ? sourceModel : passModel;
+
+      int const node = ret.addNode(model, QPointF(i * nodeSpacingX, y));
+
+      if (last >= 0)
+        ret.connect(last, node);
+
+      last = node;
+    }
+
+    GroupSpec group;
+    group.name = QStringLiteral("Group %1").arg(g);
+    group.rect = QRectF(-groupMargin,
+                        y - groupMargin,
+                        nodesPerGroup * nodeSpacingX + groupMargin,
+                        nodeSpacingY + 2 * groupMargin);
+
+    ret._groups.push_back(group);
+  }
+
+  return ret;
+}
+
+
+GraphGenerator
+GraphGenerator::
+random(int count, quint32 seed)
+{
+  // Inputs are taken from this many preceding nodes, which keeps
+  // the connections short enough to stay readable on the grid
+  int const window = 100;
+
+  GraphGenerator ret;
+  ret._nodes.reserve(count);
+
+  std::mt19937 engine(seed);
+  std::uniform_int_distribution<int> kind(0, 99);
+
+  std::vector<int> outputs;
+
+  for (int i = 0; i < count; ++i)
+  {
+    int const k = kind(engine);
+
+    QString const &model = (i == 0 || k < 5) ? sourceModel :
+                           (k < 40)          ? mergeModel :
+                                               passModel;
+
+    int const node = ret.addNode(model, gridPosition(i));
+
+    if (model != sourceModel)
+    {
+      int const first = std::max(0, static_cast<int>(outputs.size()) - window);
+
+      std::uniform_int_distribution<int> pick(first, static_cast<int>(outputs.size()) - 1);
+
+      int const inputs = (model == mergeModel) ? 2 : 1;
+
+      for (int port = 0; port < inputs; ++port)
+        ret.connect(outputs[pick(engine)], node, port);
+    }
+
+    outputs.push_back(node);
+  }
+
+  return ret;
+}
+
+
+QJsonObject
+GraphGenerator::
+toJson() const
+{
+  std::vector<QString> ids;
+  ids.reserve(_nodes.size());
+
+  QJsonArray nodesJsonArray;
+  for (auto const &spec : _nodes)
+  {
+    ids.push_back(QUuid::createUuid().toString());
+
+    QJsonObject modelJson;
+    modelJson["name"] = spec.model;
+
+    QJsonObject positionJson;
+    positionJson["x"] = spec.position.x();
+    positionJson["y"] = spec.position.y();
+
+    QJsonObject nodeJson;
+    nodeJson["id"]       = ids.back();
+    nodeJson["model"]    = modelJson;
+    nodeJson["position"] = positionJson;
+
+    nodesJsonArray.append(nodeJson);
+  }
+
+  QJsonArray connectionJsonArray;
+  for (auto const &spec : _connections)
+  {
+    QJsonObject connectionJson;
+    connectionJson["in_id"]     = ids[spec.inNode];
+    connectionJson["in_index"]  = static_cast<int>(spec.inPort);
+    connectionJson["out_id"]    = ids[spec.outNode];
+    connectionJson["out_index"] = static_cast<int>(spec.outPort);
+
+    connectionJsonArray.append(connectionJson);
+  }
+
+  QJsonArray groupsJsonArray;
+  for (auto const &spec : _groups)
+  {
+    QJsonObject positionJson;
+    positionJson["x"] = spec.rect.x();
+    positionJson["y"] = spec.rect.y();
+
+    QJsonObject sizeJson;
+    sizeJson["x"] = spec.rect.width();
+    sizeJson["y"] = spec.rect.height();
+
+    QJsonObject colorJson;
+    colorJson["r"] = 135;
+    colorJson["g"] = 135;
+    colorJson["b"] = 135;
+
+    QJsonObject groupJson;
+    groupJson["name"]      = spec.name;
+    groupJson["collapsed"] = 0;
+    groupJson["position"]  = positionJson;
+    groupJson["size"]      = sizeJson;
+    groupJson["color"]     = colorJson;
+
+    groupsJsonArray.append(groupJson);
+  }
+
+  QJsonObject sceneJson;
+  sceneJson["nodes"]       = nodesJsonArray;
+  sceneJson["connections"] = connectionJsonArray;
+  sceneJson["groups"]      = groupsJsonArray;
+
+  return sceneJson;
+}
+
+
+QByteArray
+GraphGenerator::
+toMemory() const
+{
+  return QJsonDocument(toJson()).toJson(QJsonDocument::Compact);
+}
+
+
+std::vector<Node*>
+GraphGenerator::
+populate(FlowScene &scene) const
+{
+  std::vector<Node*> nodes;
+  nodes.reserve(_nodes.size());
+
+  for (auto const &spec : _nodes)
+  {
+    Node &node = scene.createNode(scene.registry().create(spec.model));
+
+    node.nodeGraphicsObject().setPos(spec.position);
+
+    nodes.push_back(&node);
+  }
+
+  for (auto const &spec : _connections)
+  {
+    scene.createConnection(*nodes[spec.inNode], spec.inPort,
+                           *nodes[spec.outNode], spec.outPort);
+  }
+
+  for (auto const &spec : _groups)
+  {
+    Group &group = scene.createGroup();
+
+    group.SetName(spec.name);
+    group.groupGraphicsObject().nameLineEdit->setText(spec.name);
+    group.groupGraphicsObject().setPos(spec.rect.topLeft());
+    group.groupGraphicsObject().setSizeX(static_cast<int>(spec.rect.width()));
+    group.groupGraphicsObject().setSizeY(static_cast<int>(spec.rect.height()));
+
+    scene.resolveGroups(group);
+  }
+
+  return nodes;
+}
+
+
+int
+GraphGenerator::
+addNode(QString const &model, QPointF const &position)
+{
+  _nodes.push_back(NodeSpec{model, position});
+
+  return static_cast<int>(_nodes.size()) - 1;
+}
+
+
+void
+GraphGenerator::
+connect(int outNode, int inNode, PortIndex inPort)
+{
+  _connections.push_back(ConnectionSpec{outNode, 0, inNode, inPort});
+}
+
+
+QPointF
+GraphGenerator::
+gridPosition(int index, int perRow)
+{
+  return QPointF((index % perRow) * nodeSpacingX,
+                 (index / perRow) * nodeSpacingY);
+}
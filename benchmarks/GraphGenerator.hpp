@@ -0,0 +1,124 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QPointF>
+#include <QtCore/QRectF>
+#include <QtCore/QString>
+
+#include <nodes/DataModelRegistry>
+#include <nodes/FlowScene>
+#include <nodes/Node>
+
+/// Builds synthetic flows of the benchmark models (see BenchmarkModels.hpp)
+/// for stress tests and benchmarks.
+///
+/// A generated graph is a plain description of nodes, connections and
+/// groups. It can be turned into a live FlowScene with `populate` or into
+/// a document understood by `FlowScene::loadFromMemory` with `toMemory`.
+///
+/// All the shapes are deterministic, `random` depends on its seed only.
+/// Sizes are only bounded by memory, flows of 100k nodes are practical.
+class GraphGenerator
+{
+public:
+
+  struct NodeSpec
+  {
+    QString model;
+    QPointF position;
+  };
+
+  struct ConnectionSpec
+  {
+    int outNode;
+    QtNodes::PortIndex outPort;
+    int inNode;
+    QtNodes::PortIndex inPort;
+  };
+
+  struct GroupSpec
+  {
+    QString name;
+    QRectF rect;
+  };
+
+public:
+
+  /// Registry with all the models the generator uses.
+  static std::shared_ptr<QtNodes::DataModelRegistry>
+  registry();
+
+  /// Source followed by `count - 1` pass-through nodes.
+  static GraphGenerator
+  chain(int count);
+
+  /// One source feeding `width` pass-through nodes.
+  static GraphGenerator
+  fanOut(int width);
+
+  /// Source followed by `count` diamonds: two pass-through nodes
+  /// joined by a merge node, each diamond fed by the previous one.
+  static GraphGenerator
+  diamonds(int count);
+
+  /// `rows * columns` merge nodes, each fed by its upper and left neighbour.
+  static GraphGenerator
+  grid(int rows, int columns);
+
+  /// `groups` chains of `nodesPerGroup` nodes, each chain inside its own
+  /// group and fed by the last node of the previous one.
+  static GraphGenerator
+  groupedChains(int groups, int nodesPerGroup);
+
+  /// Random DAG of `count` nodes. Every node after the first one takes
+  /// its inputs from randomly chosen earlier nodes.
+  static GraphGenerator
+  random(int count, quint32 seed = 1);
+
+public:
+
+  std::vector<NodeSpec> const &
+  nodes() const { return _nodes; }
+
+  std::vector<ConnectionSpec> const &
+  connections() const { return _connections; }
+
+  std::vector<GroupSpec> const &
+  groups() const { return _groups; }
+
+  /// Scene document in the FlowScene::saveToMemory format.
+  QJsonObject
+  toJson() const;
+
+  QByteArray
+  toMemory() const;
+
+  /// Creates the graph in `scene`, whose registry must know the generator
+  /// models. Returns the created nodes in generation order.
+  std::vector<QtNodes::Node*>
+  populate(QtNodes::FlowScene &scene) const;
+
+private:
+
+  int
+  addNode(QString const &model, QPointF const &position);
+
+  void
+  connect(int outNode, int inNode, QtNodes::PortIndex inPort = 0);
+
+  /// Places node `index` on a wrapping grid, `perRow` nodes per row.
+  static QPointF
+  gridPosition(int index, int perRow = 100);
+
+private:
+
+  std::vector<NodeSpec> _nodes;
+
+  std::vector<ConnectionSpec> _connections;
+
+  std::vector<GroupSpec> _groups;
+};
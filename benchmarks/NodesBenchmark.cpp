@@ -0,0 +1,785 @@
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+#include <QtGui/QImage>
+#include <QtGui/QPainter>
+#include <QtTest/QtTest>
+#include <QtWidgets/QApplication>
+#include <QtWidgets/QStyleOptionGraphicsItem>
+
+#include <nodes/Connection>
+#include <nodes/DataModelRegistry>
+#include <nodes/FlowScene>
+#include <nodes/Node>
+#include <nodes/Payloads>
+#include <nodes/StreamChannel>
+#include <nodes/internal/Group.hpp>
+
+#include "BenchmarkModels.hpp"
+#include "DecimalData.hpp"
+#include "GraphGenerator.hpp"
+
+using QtNodes::Connection;
+using QtNodes::FlowScene;
+using QtNodes::Group;
+using QtNodes::Node;
+
+namespace
+{
+
+void
+addSizes()
+{
+  QTest::addColumn<int>("count");
+
+  QTest::newRow("100")   << 100;
+  QTest::newRow("1000")  << 1000;
+  QTest::newRow("10000") << 10000;
+}
+
+}
+
+
+/// QtTest benchmarks for the node editor core.
+/// Run with `-o results.xml,xml` (or `-csv`) for machine readable output.
+class NodesBenchmark : public QObject
+{
+  Q_OBJECT
+
+private slots:
+
+  void createNode_data() { addSizes(); }
+
+  void
+  createNode()
+  {
+    QFETCH(int, count);
+
+    FlowScene scene(GraphGenerator::registry());
+
+    QBENCHMARK_ONCE
+    {
+      for (int i = 0; i < count; ++i)
+        scene.createNode(scene.registry().create(QStringLiteral("BenchPassThrough")));
+    }
+  }
+
+  void createModels_data() { addSizes(); }
+
+  /// Models built and released the way a bulk load and its undo do.
+  void
+  createModels()
+  {
+    QFETCH(int, count);
+
+    auto registry = GraphGenerator::registry();
+
+    std::vector<std::unique_ptr<QtNodes::NodeDataModel>> models;
+    models.reserve(count);
+
+    QBENCHMARK
+    {
+      for (int i = 0; i < count; ++i)
+        models.push_back(registry->create(QStringLiteral("BenchPassThrough")));
+
+      models.clear();
+    }
+  }
+
+  void createConnection_data() { addSizes(); }
+
+  void
+  createConnection()
+  {
+    QFETCH(int, count);
+
+    FlowScene scene(GraphGenerator::registry());
+
+    std::vector<Node*> nodes;
+    for (int i = 0; i < count; ++i)
+      nodes.push_back(&scene.createNode(scene.registry().create(QStringLiteral("BenchPassThrough"))));
+
+    QBENCHMARK_ONCE
+    {
+      for (int i = 1; i < count; ++i)
+        scene.createConnection(*nodes[i], 0, *nodes[i - 1], 0);
+    }
+  }
+
+  void saveToMemory_data() { addSizes(); }
+
+  void
+  saveToMemory()
+  {
+    QFETCH(int, count);
+
+    FlowScene scene(GraphGenerator::registry());
+    GraphGenerator::chain(count).populate(scene);
+
+    QByteArray data;
+
+    QBENCHMARK
+    {
+      data = scene.saveToMemory();
+    }
+
+    QVERIFY(!data.isEmpty());
+  }
+
+  void loadFromMemory_data() { addSizes(); }
+
+  void
+  loadFromMemory()
+  {
+    QFETCH(int, count);
+
+    QByteArray const data = GraphGenerator::chain(count).toMemory();
+
+    FlowScene scene(GraphGenerator::registry());
+
+    QBENCHMARK_ONCE
+    {
+      scene.loadFromMemory(data);
+    }
+
+    QCOMPARE(static_cast<int>(scene.nodes().size()), count);
+  }
+
+  void clearScene_data() { addSizes(); }
+
+  /// Closing a scene of `count` diamonds, nothing may be evaluated.
+  void
+  clearScene()
+  {
+    QFETCH(int, count);
+
+    FlowScene scene(GraphGenerator::registry());
+    GraphGenerator::diamonds(count).populate(scene);
+
+    BenchPassThroughModel::evaluations() = 0;
+
+    QBENCHMARK_ONCE
+    {
+      scene.clearScene();
+    }
+
+    QVERIFY(scene.nodes().empty());
+    QVERIFY(scene.connections().empty());
+    QCOMPARE(BenchPassThroughModel::evaluations(), 0);
+  }
+
+  /// Closing scenes of growing size, node items inside groups included.
+  /// Eight times the nodes have to take about eight times as long, not
+  /// the sixty-four of a teardown removing the items one by one.
+  void
+  clearSceneScaling()
+  {
+    auto clearTime = [](int count)
+    {
+      FlowScene scene(GraphGenerator::registry());
+      GraphGenerator::groupedChains(count / 50, 50).populate(scene);
+
+      QElapsedTimer timer;
+      timer.start();
+
+      scene.clearScene();
+
+      return std::max<qint64>(timer.nsecsElapsed(), 1);
+    };
+
+    qint64 const small = clearTime(1000);
+    qint64 const large = clearTime(8000);
+
+    QVERIFY2(large < 24 * small,
+             qPrintable(QStringLiteral("1000 nodes: %1 ms, 8000 nodes: %2 ms")
+                        .arg(small / 1e6).arg(large / 1e6)));
+  }
+
+  void reloadScene_data() { addSizes(); }
+
+  /// Loading a scene into one that was just cleared, the way documents
+  /// are switched. Freed nodes and connections are reused.
+  void
+  reloadScene()
+  {
+    QFETCH(int, count);
+
+    QByteArray const data = GraphGenerator::chain(count).toMemory();
+
+    FlowScene scene(GraphGenerator::registry());
+
+    QBENCHMARK
+    {
+      scene.loadFromMemory(data);
+      scene.clearScene();
+    }
+
+    QVERIFY(scene.nodes().empty());
+  }
+
+  void
+  loadShape_data()
+  {
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<int>("count");
+
+    auto addShape = [](char const *name, GraphGenerator const &graph)
+    {
+      QTest::newRow(name) << graph.toMemory() << static_cast<int>(graph.nodes().size());
+    };
+
+    addShape("chain",         GraphGenerator::chain(10000));
+    addShape("fanOut",        GraphGenerator::fanOut(10000));
+    addShape("diamonds",      GraphGenerator::diamonds(3333));
+    addShape("grid",          GraphGenerator::grid(100, 100));
+    addShape("groupedChains", GraphGenerator::groupedChains(100, 100));
+    addShape("random",        GraphGenerator::random(10000));
+  }
+
+  void
+  loadShape()
+  {
+    QFETCH(QByteArray, data);
+    QFETCH(int, count);
+
+    FlowScene scene(GraphGenerator::registry());
+
+    QBENCHMARK_ONCE
+    {
+      scene.loadFromMemory(data);
+    }
+
+    QCOMPARE(static_cast<int>(scene.nodes().size()), count);
+  }
+
+  void iterateOverNodeDataDependentOrder_data() { addSizes(); }
+
+  void
+  iterateOverNodeDataDependentOrder()
+  {
+    QFETCH(int, count);
+
+    FlowScene scene(GraphGenerator::registry());
+    GraphGenerator::chain(count).populate(scene);
+
+    int visited = 0;
+
+    QBENCHMARK
+    {
+      visited = 0;
+      scene.iterateOverNodeDataDependentOrder([&visited](QtNodes::NodeDataModel*)
+      {
+        ++visited;
+      });
+    }
+
+    QCOMPARE(visited, count);
+  }
+
+  void selectionToJson_data() { addSizes(); }
+
+  void
+  selectionToJson()
+  {
+    QFETCH(int, count);
+
+    FlowScene scene(GraphGenerator::registry());
+    for (Node *node : GraphGenerator::chain(count).populate(scene))
+      node->nodeGraphicsObject().setSelected(true);
+
+    QJsonObject json;
+
+    QBENCHMARK
+    {
+      json = scene.selectionToJson(true);
+    }
+
+    QCOMPARE(json["nodes"].toArray().size(), count);
+  }
+
+  void
+  nodePainterPaint()
+  {
+    FlowScene scene(GraphGenerator::registry());
+    std::vector<Node*> nodes = GraphGenerator::chain(1000).populate(scene);
+
+    QImage image(512, 512, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    QStyleOptionGraphicsItem option;
+
+    QBENCHMARK
+    {
+      for (Node *node : nodes)
+      {
+        QGraphicsItem &item = node->nodeGraphicsObject();
+        option.exposedRect = item.boundingRect();
+        item.paint(&painter, &option, nullptr);
+      }
+    }
+  }
+
+  void
+  connectionPainterPaint()
+  {
+    FlowScene scene(GraphGenerator::registry());
+    GraphGenerator::chain(1000).populate(scene);
+
+    QImage image(512, 512, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    QStyleOptionGraphicsItem option;
+
+    QBENCHMARK
+    {
+      for (auto const &pair : scene.connections())
+      {
+        QGraphicsItem &item = pair.second->getConnectionGraphicsObject();
+        option.exposedRect = item.boundingRect();
+        item.paint(&painter, &option, nullptr);
+      }
+    }
+  }
+
+  void dragStep_data() { addSizes(); }
+
+  /// One mouse move step of a drag over `count` nodes,
+  /// including the connection update of the frame.
+  void
+  dragStep()
+  {
+    QFETCH(int, count);
+
+    FlowScene scene(GraphGenerator::registry());
+    std::vector<Node*> nodes = GraphGenerator::chain(count).populate(scene);
+
+    QBENCHMARK
+    {
+      for (Node *node : nodes)
+        node->nodeGraphicsObject().moveBy(1.0, 0.0);
+
+      scene.flushConnectionUpdates();
+    }
+  }
+
+  void deleteSelection_data() { addSizes(); }
+
+  /// Deletes every second node of a chain, the survivors lose their input.
+  void
+  deleteSelection()
+  {
+    QFETCH(int, count);
+
+    FlowScene scene(GraphGenerator::registry());
+    std::vector<Node*> nodes = GraphGenerator::chain(count).populate(scene);
+
+    for (std::size_t i = 0; i < nodes.size(); i += 2)
+      nodes[i]->nodeGraphicsObject().setSelected(true);
+
+    QBENCHMARK_ONCE
+    {
+      scene.deleteSelectedNodes();
+    }
+
+    QCOMPARE(static_cast<int>(scene.nodes().size()), count / 2);
+  }
+
+  void
+  collapsedGroupPropagation_data()
+  {
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("compiled");
+
+    for (int count : { 100, 1000, 10000 })
+    {
+      QTest::newRow(qPrintable(QStringLiteral("%1 live").arg(count)))     << count << false;
+      QTest::newRow(qPrintable(QStringLiteral("%1 compiled").arg(count))) << count << true;
+    }
+  }
+
+  /// New data entering a collapsed group holding a chain of `count` nodes.
+  void
+  collapsedGroupPropagation()
+  {
+    QFETCH(int, count);
+    QFETCH(bool, compiled);
+
+    FlowScene scene(GraphGenerator::registry());
+    std::vector<Node*> nodes = GraphGenerator::groupedChains(1, count).populate(scene);
+
+    Group &group = *scene.groups().begin()->second;
+    group.setCompiled(compiled);
+    group.groupGraphicsObject().Collapse();
+
+    auto data = std::make_shared<BenchData>(2.0);
+
+    QBENCHMARK
+    {
+      nodes[1]->propagateData(data, 0);
+    }
+  }
+
+  void paletteSearch_data() { addSizes(); }
+
+  /// One keystroke in the model menu filter, over `count` templates.
+  void
+  paletteSearch()
+  {
+    QFETCH(int, count);
+
+    auto registry = GraphGenerator::registry();
+    for (int i = 0; i < count; ++i)
+      registry->registerTemplate(QStringLiteral("Template %1").arg(i), QString());
+
+    std::vector<std::size_t> matches;
+
+    QBENCHMARK
+    {
+      matches = registry->palette().search(QStringLiteral("plate 42"));
+    }
+
+    QVERIFY(!matches.empty());
+  }
+
+  void portTypeCheck_data() { addSizes(); }
+
+  /// The type test canConnect makes, once for every connection of a chain.
+  void
+  portTypeCheck()
+  {
+    QFETCH(int, count);
+
+    FlowScene scene(GraphGenerator::registry());
+    std::vector<Node*> nodes = GraphGenerator::chain(count).populate(scene);
+
+    int compatible = 0;
+
+    QBENCHMARK
+    {
+      compatible = 0;
+
+      for (std::size_t i = 1; i < nodes.size(); ++i)
+      {
+        auto const &out = nodes[i - 1]->nodeDataModel();
+        auto const &in  = nodes[i]->nodeDataModel();
+
+        if (out->dataType(PortType::Out, 0) == in->dataType(PortType::In, 0))
+          ++compatible;
+      }
+    }
+
+    QCOMPARE(compatible, count - 1);
+  }
+
+  void variadicPort_data() { addSizes(); }
+
+  /// One input added in front of `count` connected inputs, then removed.
+  void
+  variadicPort()
+  {
+    QFETCH(int, count);
+
+    FlowScene scene(GraphGenerator::registry());
+
+    Node &source = scene.createNode(scene.registry().create(QStringLiteral("BenchSource")));
+    Node &sink   = scene.createNode(scene.registry().create(QStringLiteral("BenchVariadic")));
+
+    auto &model = static_cast<BenchVariadicModel&>(*sink.nodeDataModel());
+
+    for (int i = 0; i < count; ++i)
+    {
+      model.insertInput(i);
+      scene.createConnection(sink, i, source, 0);
+    }
+
+    QBENCHMARK
+    {
+      model.insertInput(0);
+      model.removeInput(0);
+    }
+
+    QCOMPARE(static_cast<int>(model.nPorts(PortType::In)), count);
+  }
+
+  void portHitTest_data() { addSizes(); }
+
+  /// Hovering the last input of a node with `count` inputs.
+  void
+  portHitTest()
+  {
+    QFETCH(int, count);
+
+    FlowScene scene(GraphGenerator::registry());
+
+    Node &node = scene.createNode(scene.registry().create(QStringLiteral("BenchVariadic")));
+
+    auto &model = static_cast<BenchVariadicModel&>(*node.nodeDataModel());
+    for (int i = 0; i < count; ++i)
+      model.insertInput(i);
+
+    QTransform const transform = node.nodeGraphicsObject().sceneTransform();
+    QPointF const point = node.nodeGeometry().portScenePosition(count - 1, PortType::In, transform);
+
+    PortIndex hit = QtNodes::INVALID;
+
+    QBENCHMARK
+    {
+      hit = node.nodeGeometry().checkHitScenePoint(PortType::In, point, transform);
+    }
+
+    QCOMPARE(hit, PortIndex(count - 1));
+  }
+
+  void payloadFanOut_data() { addSizes(); }
+
+  /// One large array read by `count` consumers through payload_cast.
+  void
+  payloadFanOut()
+  {
+    QFETCH(int, count);
+
+    using QtNodes::ArrayData;
+    using QtNodes::SharedBuffer;
+
+    std::shared_ptr<NodeData> const data =
+      std::make_shared<ArrayData<double>>(SharedBuffer<double>(std::vector<double>(1 << 20, 1.0)));
+
+    double const *values = std::static_pointer_cast<ArrayData<double>>(data)->values().data();
+
+    int shared = 0;
+
+    QBENCHMARK
+    {
+      shared = 0;
+
+      for (int i = 0; i < count; ++i)
+      {
+        auto array = QtNodes::payload_cast<ArrayData<double>>(data);
+        if (array && array->values().data() == values)
+          ++shared;
+      }
+    }
+
+    QCOMPARE(shared, count);
+  }
+
+  void streamChain_data() { addSizes(); }
+
+  /// `count` chunks pushed by a worker thread through a chain of eight
+  /// channels. The last reader takes one chunk per event loop pass, so
+  /// the chain backs up and every stage has to wait for room.
+  void
+  streamChain()
+  {
+    QFETCH(int, count);
+
+    using QtNodes::StreamChannel;
+    using QtNodes::StreamReader;
+
+    int const stages = 8;
+    std::size_t const capacity = 4;
+
+    std::size_t peak = 0;
+    int received = 0;
+    int refused  = 0;
+
+    QBENCHMARK_ONCE
+    {
+      std::vector<std::shared_ptr<StreamChannel>> channels;
+      std::vector<std::unique_ptr<StreamReader>> readers;
+
+      for (int i = 0; i < stages; ++i)
+      {
+        channels.push_back(std::make_shared<StreamChannel>(QtNodes::dataTypeOf<BenchData>(),
+                                                           capacity));
+        readers.push_back(std::make_unique<StreamReader>(channels.back()));
+      }
+
+      // Chunk a stage could not pass on yet
+      std::vector<std::shared_ptr<NodeData>> held(stages);
+
+      QObject context;
+      QEventLoop loop;
+
+      // Moves chunks from channel i to channel i + 1 until that one is full
+      auto forward = [&](int i)
+        {
+          for (;;)
+          {
+            if (!held[i])
+              held[i] = readers[i]->read();
+
+            if (!held[i])
+              return;
+
+            if (!channels[i + 1]->tryPush(held[i]))
+            {
+              ++refused;
+              return;
+            }
+
+            held[i].reset();
+            peak = std::max(peak, channels[i + 1]->size());
+          }
+        };
+
+      for (int i = 0; i + 1 < stages; ++i)
+      {
+        QObject::connect(channels[i].get(), &StreamChannel::chunkPushed,
+                         &context, [&forward, i]() { forward(i); },
+                         Qt::QueuedConnection);
+
+        QObject::connect(channels[i + 1].get(), &StreamChannel::spaceAvailable,
+                         &context, [&forward, i]() { forward(i); },
+                         Qt::QueuedConnection);
+      }
+
+      QTimer consumer;
+      QObject::connect(&consumer, &QTimer::timeout,
+                       [&]()
+                       {
+                         if (readers.back()->read() && ++received == count)
+                           loop.quit();
+                       });
+
+      auto const chunk = std::make_shared<BenchData>();
+
+      // Blocks in push whenever the first channel is full
+      std::thread producer([&]()
+                           {
+                             for (int i = 0; i < count; ++i)
+                               channels.front()->push(chunk);
+
+                             channels.front()->close();
+                           });
+
+      consumer.start(0);
+      loop.exec();
+
+      producer.join();
+    }
+
+    QCOMPARE(received, count);
+    QVERIFY(refused > 0);
+    QCOMPARE(peak, capacity);
+  }
+
+  void fusedChain_data() { addSizes(); }
+
+  /// A sweep of `count` * 100 values through sixteen calculator
+  /// operations, computed in one fused pass and checked against a plain
+  /// scalar loop.
+  void
+  fusedChain()
+  {
+    QFETCH(int, count);
+
+    std::size_t const size = static_cast<std::size_t>(count) * 100;
+
+    std::vector<double> sweep(size);
+    std::iota(sweep.begin(), sweep.end(), 0.0);
+
+    auto const source  = std::make_shared<DecimalData>(QtNodes::SharedBuffer<double>(sweep));
+    auto const scale   = std::make_shared<DecimalData>(1.5);
+    auto const offset  = std::make_shared<DecimalData>(0.25);
+    auto const divisor = std::make_shared<DecimalData>(3.0);
+
+    int const steps = 16;
+
+    MathOperation const operations[] = { MathOperation::Multiply,
+                                         MathOperation::Add,
+                                         MathOperation::Subtract,
+                                         MathOperation::Divide };
+
+    std::shared_ptr<DecimalData> const operands[] = { scale, offset, source, divisor };
+
+    std::shared_ptr<DecimalData> result;
+
+    QBENCHMARK
+    {
+      result = source;
+
+      for (int step = 0; step < steps; ++step)
+        result = MathExpression::combine(operations[step % 4], result, operands[step % 4]);
+
+      result->values();
+    }
+
+    QCOMPARE(result->size(), size);
+
+    double const *values = result->values();
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      double expected = sweep[i];
+
+      for (int step = 0; step < steps / 4; ++step)
+        expected = ((expected * 1.5 + 0.25) - sweep[i]) / 3.0;
+
+      if (std::abs(values[i] - expected) > 1e-12 * std::max(1.0, std::abs(expected)))
+        QFAIL(qPrintable(QStringLiteral("Value %1 is %2, expected %3")
+                         .arg(i).arg(values[i]).arg(expected)));
+    }
+  }
+
+  void undoRedo_data() { addSizes(); }
+
+  /// One drag gesture over `count` selected nodes, undone and redone.
+  void
+  undoRedo()
+  {
+    QFETCH(int, count);
+
+    FlowScene scene(GraphGenerator::registry());
+    std::vector<Node*> nodes = GraphGenerator::chain(count).populate(scene);
+
+    for (Node *node : nodes)
+      node->nodeGraphicsObject().setSelected(true);
+
+    scene.beginMoveGesture(nullptr);
+
+    for (Node *node : nodes)
+      node->nodeGraphicsObject().moveBy(10.0, 10.0);
+
+    scene.endMoveGesture();
+
+    QCOMPARE(static_cast<int>(scene.undoCommands().size()), 1);
+
+    QBENCHMARK
+    {
+      scene.Undo();
+      scene.Redo();
+    }
+  }
+};
+
+
+int
+main(int argc, char *argv[])
+{
+  // Benchmarks must run on headless build machines as well
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+  QApplication app(argc, argv);
+
+  // The library prints debug output on several hot paths, keep the results clean
+  QLoggingCategory::setFilterRules(QStringLiteral("*.debug=false"));
+
+  NodesBenchmark benchmark;
+
+  return QTest::qExec(&benchmark, argc, argv);
+}
+
+#include "NodesBenchmark.moc"
@@ -1,11 +1,22 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 #include <nodes/NodeDataModel>
+#include <nodes/Payloads>
+
+#include "MathExpression.hpp"
 
+using QtNodes::NodeData;
 using QtNodes::NodeDataType;
 
 /// The class can potentially incapsulate any user data which
 /// need to be transferred within the Node Editor graph
+///
+/// Holds a single number or a batch of them, the math models work on
+/// batches element-wise.
 class DecimalData : public NodeData
 {
 public:
@@ -18,19 +29,98 @@ public:
     : _number(number)
   {}
 
+  explicit
+  DecimalData(QtNodes::SharedBuffer<double> values)
+    : _number(0.0)
+    , _size(values.size())
+    , _values(std::move(values))
+    , _batch(true)
+    , _computed(true)
+  {}
+
+  /// A batch computed on first access.
+  explicit
+  DecimalData(std::shared_ptr<MathExpression const> expression)
+    : _number(0.0)
+    , _size(expression->size())
+    , _expression(std::move(expression))
+    , _batch(true)
+    , _computed(false)
+  {}
+
   NodeDataType type() const override
   {
-    return NodeDataType {"decimal",
-                         "Decimal"};
+    static NodeDataType const type{"decimal",
+                                   "Decimal"};
+    return type;
   }
 
+  bool isBatch() const
+  { return _batch; }
+
+  std::size_t size() const
+  { return _size; }
+
+  /// The number of a single number, batches are read through values().
   double number() const
-  { return _number; }
+  {
+    Q_ASSERT(!_batch);
+    return _number;
+  }
+
+  /// `size()` values, computed first for a pending batch.
+  double const * values() const
+  {
+    if (!_batch)
+      return &_number;
+
+    if (!_computed)
+    {
+      std::call_once(_computeOnce, [this]()
+                     {
+                       _values   = _expression->evaluate();
+                       _computed = true;
+
+                       // The inputs of the chain are not needed anymore
+                       std::atomic_store(&_expression, std::shared_ptr<MathExpression const>());
+                     });
+    }
+
+    return _values.data();
+  }
+
+  /// The expression of a batch not computed yet, nullptr otherwise.
+  std::shared_ptr<MathExpression const> pendingExpression() const
+  { return std::atomic_load(&_expression); }
 
   QString numberAsText() const
-  { return QString::number(_number, 'f'); }
+  {
+    if (!_batch)
+      return QString::number(_number, 'f');
+
+    if (size() == 0)
+      return QStringLiteral("(0 values)");
+
+    // Shown once the chain ends, computing the batch here is expected
+    return QStringLiteral("%1 (%2 values)")
+           .arg(QString::number(values()[0], 'f'))
+           .arg(size());
+  }
 
 private:
 
   double _number;
+
+  std::size_t _size = 1;
+
+  // Dropped once computed, together with the leaves it holds
+  mutable std::shared_ptr<MathExpression const> _expression;
+
+  mutable QtNodes::SharedBuffer<double> _values;
+
+  mutable std::once_flag _computeOnce;
+
+  bool _batch = false;
+
+  mutable std::atomic<bool> _computed{ true };
 };
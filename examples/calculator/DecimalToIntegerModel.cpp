@@ -45,9 +45,9 @@ DecimalToIntegerModel::
 dataType(PortType portType, PortIndex) const
 {
   if (portType == PortType::In)
-    return DecimalData().type();
+    return QtNodes::dataTypeOf<DecimalData>();
 
-  return IntegerData().type();
+  return QtNodes::dataTypeOf<IntegerData>();
 }
 
 
@@ -71,10 +71,44 @@ setInData(std::shared_ptr<NodeData> data, PortIndex portIndex)
     _decimal = numberData;
   }
 
-  if (_decimal)
+  // Converting only the first value would hide the others, and still
+  // compute all of them
+  if (_decimal && _decimal->isBatch())
+  {
+    modelValidationState = NodeValidationState::Warning;
+    modelValidationError = QStringLiteral("Batches cannot be converted to an integer");
+    _integer.reset();
+  }
+  else if (_decimal)
+  {
+    modelValidationState = NodeValidationState::Valid;
+    modelValidationError = QString();
     _integer = std::make_shared<IntegerData>(_decimal->number());
+  }
+  else
+  {
+    modelValidationState = NodeValidationState::Warning;
+    modelValidationError = QStringLiteral("Missing or incorrect inputs");
+    _integer.reset();
+  }
 
   PortIndex const outPortIndex = 0;
 
   emit dataUpdated(outPortIndex);
 }
+
+
+NodeValidationState
+DecimalToIntegerModel::
+validationState() const
+{
+  return modelValidationState;
+}
+
+
+QString
+DecimalToIntegerModel::
+validationMessage() const
+{
+  return modelValidationError;
+}
@@ -12,6 +12,7 @@ using QtNodes::PortIndex;
 using QtNodes::NodeData;
 using QtNodes::NodeDataType;
 using QtNodes::NodeDataModel;
+using QtNodes::NodeValidationState;
 
 class DecimalData;
 class IntegerData;
@@ -67,8 +68,17 @@ public:
   QWidget *
   embeddedWidget() override { return nullptr; }
 
+  NodeValidationState
+  validationState() const override;
+
+  QString
+  validationMessage() const override;
+
 private:
 
   std::shared_ptr<DecimalData> _decimal;
   std::shared_ptr<IntegerData> _integer;
+
+  NodeValidationState modelValidationState = NodeValidationState::Warning;
+  QString modelValidationError = QString("Missing or incorrect inputs");
 };
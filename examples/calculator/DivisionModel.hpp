@@ -70,7 +70,8 @@ private:
     auto n1 = _number1.lock();
     auto n2 = _number2.lock();
 
-    if (n2 && (n2->number() == 0.0))
+    // Zeros in a divisor batch give infinities, like the IEEE division
+    if (n2 && !n2->isBatch() && (n2->number() == 0.0))
     {
       modelValidationState = NodeValidationState::Error;
       modelValidationError = QStringLiteral("Division by zero error");
@@ -80,8 +81,7 @@ private:
     {
       modelValidationState = NodeValidationState::Valid;
       modelValidationError = QString();
-      _result = std::make_shared<DecimalData>(n1->number() /
-                                              n2->number());
+      _result = MathExpression::combine(MathOperation::Divide, n1, n2);
     }
     else
     {
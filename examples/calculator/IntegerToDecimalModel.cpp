@@ -45,9 +45,9 @@ IntegerToDecimalModel::
 dataType(PortType portType, PortIndex) const
 {
   if (portType == PortType::In)
-    return IntegerData().type();
+    return QtNodes::dataTypeOf<IntegerData>();
 
-  return DecimalData().type();
+  return QtNodes::dataTypeOf<DecimalData>();
 }
 
 
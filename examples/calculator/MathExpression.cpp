@@ -0,0 +1,253 @@
+#include "MathExpression.hpp"
+
+#include <algorithm>
+
+#include "DecimalData.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CALCULATOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+// Values per pass of the program, a few blocks of them fit in the L1 cache
+std::size_t const blockSize = 512;
+
+// Longer expressions are cut, their operands become leaves
+std::size_t const maxInstructions = 256;
+
+struct Operand
+{
+  double const *values;
+
+  /// Broadcast values[0].
+  bool scalar;
+};
+
+
+struct Add
+{
+  static double apply(double a, double b) { return a + b; }
+
+#ifdef CALCULATOR_SSE2
+  static __m128d apply(__m128d a, __m128d b) { return _mm_add_pd(a, b); }
+#endif
+};
+
+
+struct Subtract
+{
+  static double apply(double a, double b) { return a - b; }
+
+#ifdef CALCULATOR_SSE2
+  static __m128d apply(__m128d a, __m128d b) { return _mm_sub_pd(a, b); }
+#endif
+};
+
+
+struct Multiply
+{
+  static double apply(double a, double b) { return a * b; }
+
+#ifdef CALCULATOR_SSE2
+  static __m128d apply(__m128d a, __m128d b) { return _mm_mul_pd(a, b); }
+#endif
+};
+
+
+struct Divide
+{
+  static double apply(double a, double b) { return a / b; }
+
+#ifdef CALCULATOR_SSE2
+  static __m128d apply(__m128d a, __m128d b) { return _mm_div_pd(a, b); }
+#endif
+};
+
+
+// `out` may be the values of `a`, never those of `b`
+template<typename Operation>
+void
+applyKernel(Operand a, Operand b, double *out, std::size_t n)
+{
+  std::size_t i = 0;
+
+#ifdef CALCULATOR_SSE2
+  __m128d const aBroadcast = _mm_set1_pd(a.values[0]);
+  __m128d const bBroadcast = _mm_set1_pd(b.values[0]);
+
+  for (; i + 2 <= n; i += 2)
+  {
+    __m128d const x = a.scalar ? aBroadcast : _mm_loadu_pd(a.values + i);
+    __m128d const y = b.scalar ? bBroadcast : _mm_loadu_pd(b.values + i);
+
+    _mm_storeu_pd(out + i, Operation::apply(x, y));
+  }
+#endif
+
+  for (; i < n; ++i)
+  {
+    out[i] = Operation::apply(a.scalar ? a.values[0] : a.values[i],
+                              b.scalar ? b.values[0] : b.values[i]);
+  }
+}
+
+
+void
+applyKernel(MathOperation operation, Operand a, Operand b, double *out, std::size_t n)
+{
+  switch (operation)
+  {
+    case MathOperation::Add:
+      applyKernel<Add>(a, b, out, n);
+      break;
+
+    case MathOperation::Subtract:
+      applyKernel<Subtract>(a, b, out, n);
+      break;
+
+    case MathOperation::Multiply:
+      applyKernel<Multiply>(a, b, out, n);
+      break;
+
+    case MathOperation::Divide:
+      applyKernel<Divide>(a, b, out, n);
+      break;
+  }
+}
+
+}
+
+std::shared_ptr<DecimalData>
+MathExpression::
+combine(MathOperation operation,
+        std::shared_ptr<DecimalData> const &a,
+        std::shared_ptr<DecimalData> const &b)
+{
+  if (!a->isBatch() && !b->isBatch())
+  {
+    double result;
+    applyKernel(operation, Operand{ a->values(), true }, Operand{ b->values(), true },
+                &result, 1);
+
+    return std::make_shared<DecimalData>(result);
+  }
+
+  auto expression = std::make_shared<MathExpression>();
+
+  if (!a->isBatch())
+    expression->_size = b->size();
+  else if (!b->isBatch())
+    expression->_size = a->size();
+  else
+    expression->_size = std::min(a->size(), b->size());
+
+  expression->append(a);
+
+  std::size_t const aDepth = expression->_depth;
+
+  expression->_depth = 0;
+  expression->append(b);
+
+  // b is computed on top of the result of a
+  expression->_depth = std::max(aDepth, expression->_depth + 1);
+
+  expression->_program.push_back(Instruction{ false, operation, 0 });
+
+  return std::make_shared<DecimalData>(std::move(expression));
+}
+
+
+void
+MathExpression::
+append(std::shared_ptr<DecimalData> const &data)
+{
+  auto const pending = data->pendingExpression();
+
+  if (!pending || _program.size() + pending->_program.size() > maxInstructions)
+  {
+    _program.push_back(Instruction{ true, MathOperation::Add, _leaves.size() });
+    _leaves.push_back(data);
+    _depth = std::max<std::size_t>(_depth, 1);
+    return;
+  }
+
+  // Inline the pending program, its leaves go after ours
+  std::size_t const leafOffset = _leaves.size();
+
+  for (Instruction instruction : pending->_program)
+  {
+    if (instruction.load)
+      instruction.leaf += leafOffset;
+
+    _program.push_back(instruction);
+  }
+
+  _leaves.insert(_leaves.end(), pending->_leaves.begin(), pending->_leaves.end());
+  _depth = std::max(_depth, pending->_depth);
+}
+
+
+QtNodes::SharedBuffer<double>
+MathExpression::
+evaluate() const
+{
+  std::vector<double> result(_size);
+
+  if (_size == 0)
+    return QtNodes::SharedBuffer<double>(std::move(result));
+
+  // Leaves that are pending batches themselves are computed here, once
+  std::vector<Operand> leaves;
+  leaves.reserve(_leaves.size());
+
+  for (auto const &leaf : _leaves)
+    leaves.push_back(Operand{ leaf->values(), !leaf->isBatch() });
+
+  // One block of intermediate values per stack slot
+  std::vector<std::vector<double>> scratch(_depth,
+                                           std::vector<double>(std::min(blockSize, _size)));
+
+  std::vector<Operand> stack;
+  stack.reserve(_depth);
+
+  for (std::size_t begin = 0; begin < _size; begin += blockSize)
+  {
+    std::size_t const n = std::min(blockSize, _size - begin);
+
+    stack.clear();
+
+    for (std::size_t i = 0; i < _program.size(); ++i)
+    {
+      Instruction const &instruction = _program[i];
+
+      if (instruction.load)
+      {
+        Operand leaf = leaves[instruction.leaf];
+        if (!leaf.scalar)
+          leaf.values += begin;
+
+        stack.push_back(leaf);
+        continue;
+      }
+
+      Operand const b = stack.back();
+      stack.pop_back();
+
+      Operand const a = stack.back();
+      stack.pop_back();
+
+      // The slot of `a` is reused, the last step writes the result directly
+      double *out = (i + 1 == _program.size()) ? result.data() + begin
+                                               : scratch[stack.size()].data();
+
+      applyKernel(instruction.operation, a, b, out, n);
+
+      stack.push_back(Operand{ out, false });
+    }
+  }
+
+  return QtNodes::SharedBuffer<double>(std::move(result));
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <nodes/Payloads>
+
+class DecimalData;
+
+enum class MathOperation
+{
+  Add,
+  Subtract,
+  Multiply,
+  Divide
+};
+
+/// Element-wise arithmetic on DecimalData batches, computed lazily.
+///
+/// A math model fed with batches computes nothing, it only combines the
+/// expressions of its inputs into a bigger one. The values are computed
+/// when first read, in a single pass over blocks short enough for the
+/// intermediate results to stay in the cache, with SSE2 kernels where
+/// available. A chain of N operations then walks and allocates one array
+/// instead of N.
+///
+/// A scalar operand is broadcast over the batch, two batches are combined
+/// up to the length of the shorter one. A batch read by several branches
+/// is computed again by each of them unless it was read on its own before.
+class MathExpression
+{
+public:
+
+  /// `a` `operation` `b`, computed right away if both are scalars.
+  static std::shared_ptr<DecimalData>
+  combine(MathOperation operation,
+          std::shared_ptr<DecimalData> const &a,
+          std::shared_ptr<DecimalData> const &b);
+
+  /// Number of values of the result.
+  std::size_t
+  size() const { return _size; }
+
+  /// Computes all the values.
+  QtNodes::SharedBuffer<double>
+  evaluate() const;
+
+private:
+
+  /// Postfix step, pushes a leaf or applies an operation to the two
+  /// topmost values.
+  struct Instruction
+  {
+    bool load;
+    MathOperation operation;
+    std::size_t leaf;
+  };
+
+  /// Appends the instructions computing `data`.
+  void
+  append(std::shared_ptr<DecimalData> const &data);
+
+private:
+
+  std::vector<Instruction> _program;
+
+  /// Batches and scalars with values, read by the load instructions.
+  std::vector<std::shared_ptr<DecimalData>> _leaves;
+
+  /// Values on the stack at most while running the program.
+  std::size_t _depth = 0;
+
+  std::size_t _size = 0;
+};
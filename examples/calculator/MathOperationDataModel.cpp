@@ -1,5 +1,7 @@
 #include "MathOperationDataModel.hpp"
 
+#include <nodes/Payloads>
+
 #include "DecimalData.hpp"
 
 unsigned int
@@ -21,7 +23,7 @@ NodeDataType
 MathOperationDataModel::
 dataType(PortType, PortIndex) const
 {
-  return DecimalData().type();
+  return QtNodes::dataTypeOf<DecimalData>();
 }
 
 
@@ -37,8 +39,7 @@ void
 MathOperationDataModel::
 setInData(std::shared_ptr<NodeData> data, PortIndex portIndex)
 {
-  auto numberData =
-    std::dynamic_pointer_cast<DecimalData>(data);
+  auto numberData = QtNodes::payload_cast<DecimalData>(data);
 
   if (portIndex == 0)
   {
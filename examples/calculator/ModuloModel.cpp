@@ -43,7 +43,7 @@ NodeDataType
 ModuloModel::
 dataType(PortType, PortIndex) const
 {
-  return IntegerData().type();
+  return QtNodes::dataTypeOf<IntegerData>();
 }
 
 
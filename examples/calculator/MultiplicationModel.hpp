@@ -46,8 +46,7 @@ private:
     {
       modelValidationState = NodeValidationState::Valid;
       modelValidationError = QString();
-      _result = std::make_shared<DecimalData>(n1->number() *
-                                              n2->number());
+      _result = MathExpression::combine(MathOperation::Multiply, n1, n2);
     }
     else
     {
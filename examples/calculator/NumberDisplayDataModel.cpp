@@ -37,7 +37,7 @@ NodeDataType
 NumberDisplayDataModel::
 dataType(PortType, PortIndex) const
 {
-  return DecimalData().type();
+  return QtNodes::dataTypeOf<DecimalData>();
 }
 
 
@@ -56,6 +56,8 @@ setInData(std::shared_ptr<NodeData> data, int)
 {
   auto numberData = std::dynamic_pointer_cast<DecimalData>(data);
 
+  QSize const size = _label->size();
+
   if (numberData)
   {
     modelValidationState = NodeValidationState::Valid;
@@ -70,6 +72,9 @@ setInData(std::shared_ptr<NodeData> data, int)
   }
 
   _label->adjustSize();
+
+  if (_label->size() != size)
+    emit layoutChanged();
 }
 
 
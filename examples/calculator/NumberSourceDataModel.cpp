@@ -104,7 +104,7 @@ NodeDataType
 NumberSourceDataModel::
 dataType(PortType, PortIndex) const
 {
-  return DecimalData().type();
+  return QtNodes::dataTypeOf<DecimalData>();
 }
 
 
@@ -0,0 +1,81 @@
+#include "SweepSourceDataModel.hpp"
+
+#include <numeric>
+#include <vector>
+
+#include <QtCore/QJsonValue>
+
+#include "DecimalData.hpp"
+
+SweepSourceDataModel::
+SweepSourceDataModel()
+  : _spinBox(new QSpinBox())
+{
+  _spinBox->setRange(1, 100000000);
+  _spinBox->setSuffix(QStringLiteral(" values"));
+
+  connect(_spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+          this, &SweepSourceDataModel::onCountChanged);
+
+  _spinBox->setValue(1000);
+}
+
+
+QJsonObject
+SweepSourceDataModel::
+save() const
+{
+  QJsonObject modelJson = NodeDataModel::save();
+
+  modelJson["count"] = _spinBox->value();
+
+  return modelJson;
+}
+
+
+void
+SweepSourceDataModel::
+restore(QJsonObject const &p)
+{
+  QJsonValue v = p["count"];
+
+  if (!v.isUndefined())
+    _spinBox->setValue(v.toInt());
+}
+
+
+unsigned int
+SweepSourceDataModel::
+nPorts(PortType portType) const
+{
+  return (portType == PortType::Out) ? 1 : 0;
+}
+
+
+void
+SweepSourceDataModel::
+onCountChanged(int count)
+{
+  std::vector<double> values(count);
+  std::iota(values.begin(), values.end(), 0.0);
+
+  _values = std::make_shared<DecimalData>(QtNodes::SharedBuffer<double>(std::move(values)));
+
+  emit dataUpdated(0);
+}
+
+
+NodeDataType
+SweepSourceDataModel::
+dataType(PortType, PortIndex) const
+{
+  return QtNodes::dataTypeOf<DecimalData>();
+}
+
+
+std::shared_ptr<NodeData>
+SweepSourceDataModel::
+outData(PortIndex)
+{
+  return _values;
+}
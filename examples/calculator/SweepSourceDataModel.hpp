@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QtCore/QObject>
+#include <QtWidgets/QSpinBox>
+
+#include <nodes/NodeDataModel>
+
+class DecimalData;
+
+using QtNodes::PortType;
+using QtNodes::PortIndex;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+using QtNodes::NodeDataModel;
+
+/// Emits the batch 0, 1, ..., count - 1. The math models scale and shift
+/// it into the swept parameter.
+class SweepSourceDataModel
+  : public NodeDataModel
+{
+  Q_OBJECT
+
+public:
+  SweepSourceDataModel();
+
+  virtual
+  ~SweepSourceDataModel() {}
+
+public:
+
+  QString
+  caption() const override
+  { return QStringLiteral("Sweep Source"); }
+
+  QString
+  name() const override
+  { return QStringLiteral("SweepSource"); }
+
+  std::unique_ptr<NodeDataModel>
+  clone() const override
+  { return std::make_unique<SweepSourceDataModel>(); }
+
+public:
+
+  QJsonObject
+  save() const override;
+
+  void
+  restore(QJsonObject const &p) override;
+
+public:
+
+  unsigned int
+  nPorts(PortType portType) const override;
+
+  NodeDataType
+  dataType(PortType portType, PortIndex portIndex) const override;
+
+  std::shared_ptr<NodeData>
+  outData(PortIndex port) override;
+
+  void
+  setInData(std::shared_ptr<NodeData>, int) override
+  { }
+
+  QWidget *
+  embeddedWidget() override { return _spinBox; }
+
+private slots:
+
+  void
+  onCountChanged(int count);
+
+private:
+
+  std::shared_ptr<DecimalData> _values;
+
+  QSpinBox * _spinBox;
+};
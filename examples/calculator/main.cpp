@@ -10,6 +10,7 @@
 #include <nodes/DataModelRegistry>
 
 #include "NumberSourceDataModel.hpp"
+#include "SweepSourceDataModel.hpp"
 #include "NumberDisplayDataModel.hpp"
 #include "AdditionModel.hpp"
 #include "SubtractionModel.hpp"
@@ -30,6 +31,8 @@ registerDataModels()
   auto ret = std::make_shared<DataModelRegistry>();
   ret->registerModel<NumberSourceDataModel>("Sources");
 
+  ret->registerModel<SweepSourceDataModel>("Sources");
+
   ret->registerModel<NumberDisplayDataModel>("Displays");
 
   ret->registerModel<AdditionModel>("Operators");
@@ -59,6 +59,8 @@ public:
   {
     auto textData = std::dynamic_pointer_cast<TextData>(data);
 
+    QSize const size = _label->size();
+
     if (textData)
     {
       _label->setText(textData->text());
@@ -69,6 +71,9 @@ public:
     }
 
     _label->adjustSize();
+
+    if (_label->size() != size)
+      emit layoutChanged();
   }
 
   QWidget *
@@ -6,6 +6,7 @@
 #include <QtWidgets/QFileDialog>
 
 #include <nodes/DataModelRegistry>
+#include <nodes/Payloads>
 
 #include "PixmapData.hpp"
 
@@ -60,7 +61,7 @@ eventFilter(QObject *object, QEvent *event)
 
     if (event->type() == QEvent::Resize)
     {
-      auto d = std::dynamic_pointer_cast<PixmapData>(_nodeData);
+      auto d = QtNodes::payload_cast<PixmapData>(_nodeData);
       if (d)
       {
         _label->setPixmap(d->pixmap().scaled(w, h, Qt::KeepAspectRatio));
@@ -96,12 +97,13 @@ setInData(std::shared_ptr<NodeData> nodeData, PortIndex)
 
   if (_nodeData)
   {
-    auto d = std::dynamic_pointer_cast<PixmapData>(_nodeData);
+    auto d = QtNodes::payload_cast<PixmapData>(_nodeData);
 
     int w = _label->width();
     int h = _label->height();
 
-    _label->setPixmap(d->pixmap().scaled(w, h, Qt::KeepAspectRatio));
+    if (d)
+      _label->setPixmap(d->pixmap().scaled(w, h, Qt::KeepAspectRatio));
   }
   else
   {
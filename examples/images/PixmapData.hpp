@@ -22,11 +22,14 @@ public:
   NodeDataType
   type() const override
   {
-    //       id      name
-    return {"pixmap", "P"};
+    // Read through payload_cast, the id must not clash with another type
+    //                              id             name
+    static NodeDataType const type{"images.pixmap", "P"};
+    return type;
   }
 
-  QPixmap
+  /// Shared with every node the data reaches, QPixmap copies on write.
+  QPixmap const &
   pixmap() const { return _pixmap; }
 
 private:
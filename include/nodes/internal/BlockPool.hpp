@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Export.hpp"
+
+namespace QtNodes
+{
+
+/// Free lists of small fixed size blocks, for the objects a scene creates
+/// and destroys by the thousand.
+///
+/// Requests are rounded up to a multiple of 16 bytes, each size has its
+/// own list. Blocks are carved out of 64 KiB chunks that are kept for the
+/// lifetime of the program and reused, larger requests go straight to
+/// the global operator new. Safe to use from any thread.
+class NODE_EDITOR_PUBLIC BlockPool
+{
+public:
+
+  static void*
+  allocate(std::size_t size);
+
+  /// `size` must be the one given to allocate.
+  static void
+  deallocate(void *block, std::size_t size);
+};
+
+
+/// Standard allocator drawing from BlockPool, for containers and
+/// std::allocate_shared.
+template<typename T>
+struct PoolAllocator
+{
+  using value_type = T;
+
+  PoolAllocator() = default;
+
+  template<typename U>
+  PoolAllocator(PoolAllocator<U> const &) {}
+
+  T*
+  allocate(std::size_t n)
+  { return static_cast<T*>(BlockPool::allocate(n * sizeof(T))); }
+
+  void
+  deallocate(T *p, std::size_t n)
+  { BlockPool::deallocate(p, n * sizeof(T)); }
+};
+
+
+template<typename T, typename U>
+bool
+operator==(PoolAllocator<T> const &, PoolAllocator<U> const &) { return true; }
+
+
+template<typename T, typename U>
+bool
+operator!=(PoolAllocator<T> const &, PoolAllocator<U> const &) { return false; }
+}
@@ -75,6 +75,10 @@ public:
   void
   setGraphicsObject(std::unique_ptr<ConnectionGraphicsObject>&& graphics);
 
+  /// Leaves the graphics object to its scene, see FlowScene::clearScene.
+  ConnectionGraphicsObject *
+  releaseGraphicsObject();
+
   /// Assigns a node to the required port.
   /// It is assumed that there is a required port, no extra checks
   void
@@ -116,6 +120,11 @@ public:
 
   PortIndex
   getPortIndex(PortType portType) const;
+
+  /// Renumbers the port the connection is attached to, for ports moving
+  /// on their node, see Node::insertPort.
+  void
+  setPortIndex(PortType portType, PortIndex portIndex);
   
   PortIndex
   getGroupPortIndex(PortType portType) const;
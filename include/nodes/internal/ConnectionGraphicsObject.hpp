@@ -6,6 +6,8 @@
 
 #include <QtWidgets/QGraphicsObject>
 
+#include "BlockPool.hpp"
+
 class QGraphicsSceneMouseEvent;
 
 namespace QtNodes
@@ -30,6 +32,13 @@ public:
   virtual
   ~ConnectionGraphicsObject();
 
+  /// Allocated from a BlockPool, like the Connection itself.
+  static void*
+  operator new(std::size_t size) { return BlockPool::allocate(size); }
+
+  static void
+  operator delete(void *p, std::size_t size) { BlockPool::deallocate(p, size); }
+
   enum { Type = UserType + 2 };
   int
   type() const override { return Type; }
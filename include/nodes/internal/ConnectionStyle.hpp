@@ -8,6 +8,8 @@
 namespace QtNodes
 {
 
+struct NodeDataType;
+
 class NODE_EDITOR_PUBLIC ConnectionStyle : public Style
 {
 public:
@@ -33,6 +35,8 @@ public:
   QColor constructionColor() const;
   QColor normalColor() const;
   QColor normalColor(QString typeId) const;
+  /// Same as normalColor(dataType.id()), worked out once per type.
+  QColor normalColor(NodeDataType const &dataType) const;
   QColor selectedColor() const;
   QColor selectedHaloColor() const;
   QColor hoveredColor() const;
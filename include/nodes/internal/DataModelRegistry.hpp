@@ -7,12 +7,15 @@
 #include <QtCore/QString>
 
 #include "NodeDataModel.hpp"
+#include "ModelPalette.hpp"
 #include "Export.hpp"
 #include "QStringStdHash.hpp"
 
 namespace QtNodes
 {
 
+struct SceneFragment;
+
 /// Class uses map for storing models (name, model)
 class NODE_EDITOR_PUBLIC DataModelRegistry
 {
@@ -33,9 +36,9 @@ public:
     NodeDataType    DestinationType{};
   };
 
-  using ConvertingTypesPair = std::pair<QString, QString>; //Source type ID, Destination type ID in this order
+  using ConvertingTypesKey = quint64; //Source type handle in the high half, destination in the low half
   using TypeConverterItemPtr = std::unique_ptr<TypeConverterItem>;
-  using RegisteredTypeConvertersMap = std::map<ConvertingTypesPair, TypeConverterItemPtr>;
+  using RegisteredTypeConvertersMap = std::unordered_map<ConvertingTypesKey, TypeConverterItemPtr>;
 
   DataModelRegistry()  = default;
   ~DataModelRegistry() = default;
@@ -64,6 +67,7 @@ public:
       _registeredModels[name] = std::move(uniqueModel);
       _categories.insert(category);
       _registeredModelsCategory[name] = category;
+      _palette.addEntry(name, category, false);
     }
 
     if (TypeConverter)
@@ -73,7 +77,7 @@ public:
       //Type converter node should have exactly one input and output ports, if thats not the case, we skip the registration.
       //If the input and output type is the same, we also skip registration, because thats not a typecast node.
       if (registeredModelRef->nPorts(PortType::In) != 1 || registeredModelRef->nPorts(PortType::Out) != 1 ||
-        registeredModelRef->dataType(PortType::In, 0).id == registeredModelRef->dataType(PortType::Out, 0).id)
+        registeredModelRef->dataType(PortType::In, 0) == registeredModelRef->dataType(PortType::Out, 0))
       {
         return;
       }
@@ -83,8 +87,8 @@ public:
       converter->SourceType = converter->Model->dataType(PortType::In, 0);
       converter->DestinationType = converter->Model->dataType(PortType::Out, 0);
 
-      auto typeConverterKey = std::make_pair(converter->SourceType.id, converter->DestinationType.id);
-	    _registeredTypeConverters[typeConverterKey] = std::move(converter);
+      auto typeConverterKey = converterKey(converter->SourceType.handle(), converter->DestinationType.handle());
+      _registeredTypeConverters[typeConverterKey] = std::move(converter);
     }
   }
 
@@ -92,14 +96,23 @@ public:
   registerTemplate(QString templateName, QString templateFilePath)
   {
       _registeredTemplates[templateName] = templateFilePath;
+      _templateDefinitions.erase(templateName);
+      _palette.addEntry(templateName, QStringLiteral("Templates"), true);
   }
 
   void 
   removeTemplate(QString templateName)
   {
     _registeredTemplates.erase(templateName);
+    _templateDefinitions.erase(templateName);
+    _palette.removeEntry(templateName, true);
   }
 
+  /// Content of a registered template, parsed from its file on first use
+  /// and shared by every insertion. nullptr if the file can't be read.
+  std::shared_ptr<SceneFragment const>
+  templateDefinition(QString const &templateName);
+
 
   //Parameter order alias, so a category can be set without forcing to manually pass a model instance
   template<typename ModelType, bool TypeConverter = false>
@@ -124,10 +137,35 @@ public:
   CategoriesSet const &
   categories() const;
 
+  /// Search index of the registered models and templates.
+  ModelPalette const &
+  palette() const;
+
   std::unique_ptr<NodeDataModel>
   getTypeConverter(QString const &sourceTypeID,
                    QString const &destTypeID) const;
 
+  /// Same as above, looked up by the interned type handles.
+  std::unique_ptr<NodeDataModel>
+  getTypeConverter(NodeDataType const &sourceType,
+                   NodeDataType const &destType) const;
+
+  /// Whether getTypeConverter would succeed, without creating the model.
+  bool
+  hasTypeConverter(NodeDataType const &sourceType,
+                   NodeDataType const &destType) const
+  {
+    return _registeredTypeConverters.count(converterKey(sourceType.handle(), destType.handle())) != 0;
+  }
+
+private:
+
+  static ConvertingTypesKey
+  converterKey(TypeHandle sourceType, TypeHandle destType)
+  {
+    return (ConvertingTypesKey(sourceType) << 32) | destType;
+  }
+
 private:
 
   RegisteredModelsCategoryMap _registeredModelsCategory{};
@@ -136,5 +174,16 @@ private:
   RegisteredTypeConvertersMap _registeredTypeConverters{};
 
   RegisteredTemplatesMap _registeredTemplates{};
+
+  ModelPalette _palette{};
+
+  struct TemplateDefinition
+  {
+    QString filePath;
+    std::shared_ptr<SceneFragment const> fragment;
+  };
+
+  // Parsed templates, along with the file they were read from
+  std::unordered_map<QString, TemplateDefinition> _templateDefinitions{};
 };
 }
@@ -1,22 +1,29 @@
 #pragma once
 
+#include <QtCore/QTimer>
 #include <QtCore/QUuid>
 #include <QtWidgets/QGraphicsScene>
 
 #include <unordered_map>
+#include <unordered_set>
 #include <tuple>
 #include <memory>
 #include <functional>
+#include <deque>
+#include <map>
 
 #include "QUuidStdHash.hpp"
 #include "Export.hpp"
 #include "DataModelRegistry.hpp"
+#include "PropagationTrace.hpp"
+#include "UndoCommands.hpp"
 #include <stack>
 
 namespace QtNodes
 {
 
 class NodeDataModel;
+class NodeData;
 class FlowItemInterface;
 class Node;
 class Group;
@@ -24,22 +31,10 @@ class NodeGraphicsObject;
 class Connection;
 class ConnectionGraphicsObject;
 class NodeStyle;
+struct SceneFragment;
 
 
 
-struct UndoRedoAction {
-
-  std::function<int(void*)> undoAction;
-  std::function<int(void*)> redoAction;
-  QString name;
-  UndoRedoAction(std::function<int(void*)> undoAction, std::function<int(void*)> redoAction, const QString &name) {
-    this->undoAction = undoAction;
-    this->redoAction = redoAction;
-    this->name = name;
-  };
-};
-
-
 struct Anchor {
   QPointF position;
   double scale;
@@ -57,8 +52,6 @@ public:
 
   ~FlowScene();
 
-  std::vector<UndoRedoAction> undoActions;
-  std::vector<UndoRedoAction> redoActions;
   void PrintActions();
   int historyInx; 
 public:
@@ -89,7 +82,8 @@ public:
 
   Node&restoreNode(QJsonObject const& nodeJson, bool keepId=false);
   
-  Group& restoreGroup(QJsonObject const& nodeJson);
+  /// With `keepId`, the group gets the id saved in `nodeJson`, if any.
+  Group& restoreGroup(QJsonObject const& nodeJson, bool keepId=false);
 
   QUuid pasteNode(QJsonObject &json, QPointF nodeGroupCentroid, QPointF mousePos);
   
@@ -123,6 +117,33 @@ public:
 
   void resolveGroups(Node& n);
 
+  /// Group directly containing `node`, nullptr at the top level.
+  Group* nodeGroup(Node const& node) const;
+
+  /// Group directly containing `group`, nullptr at the top level.
+  Group* parentGroup(Group const& group) const;
+
+  /// Files a connection under the groups of its two nodes, see
+  /// Group::connections. Called once both ends of the connection are set.
+  void trackConnection(Connection& connection);
+
+  /// Reverses trackConnection, called before an end is cleared.
+  void untrackConnection(Connection& connection);
+
+  /// Marks the connections of `node` for an end point update. All the
+  /// marked connections are moved once, right after the current events.
+  void scheduleConnectionUpdate(Node const& node);
+
+  /// Moves the connections marked by scheduleConnectionUpdate now.
+  void flushConnectionUpdates();
+
+  /// Grows the tracked content bounds to include `rect` (scene coordinates).
+  /// Constant time; the scene rect itself follows on a throttled timer.
+  void expandSceneRect(QRectF const& rect);
+
+  /// Applies the pending content bounds to the scene rect now.
+  void flushSceneRect();
+
 public:
 
   std::unordered_map<QUuid, std::shared_ptr<Node> > const &nodes() const;
@@ -130,10 +151,20 @@ public:
 
   std::unordered_map<QUuid, std::shared_ptr<Connection> > const &connections() const;
 
-  std::vector<Node*> selectedNodes() const;
+  std::unordered_map<QUuid, std::shared_ptr<Group> > const &groups() const;
+
+  /// Selected elements by type. The lists are cached and rebuilt at most
+  /// once per selection change, removals invalidate them as well.
+  std::vector<Node*> const &selectedNodes() const;
+
+  std::vector<Connection*> const &selectedConnections() const;
+
+  std::vector<Group*> const &selectedGroups() const;
 
 public:
 
+  /// Deletes every node, connection and group. Items added to the scene
+  /// by hand are deleted too.
   void clearScene();
 
   void save() const;
@@ -146,8 +177,20 @@ public:
 
   void loadFromMemory(const QByteArray& data);
   
+  /// Records a closure based action, see ActionCommand.
   void AddAction(UndoRedoAction action);
 
+  /// Records an already executed command. Merges it into the previous
+  /// one when possible and evicts the oldest history above the memory limit.
+  void pushCommand(std::unique_ptr<UndoCommand> command);
+
+  /// Remembers the scene positions of the selected nodes and groups,
+  /// and of `grabbed`, when a drag starts.
+  void beginMoveGesture(QGraphicsItem *grabbed);
+
+  /// Records everything the drag moved as one MoveCommand.
+  void endMoveGesture();
+
   void Undo();
   
   void Redo();
@@ -156,9 +199,23 @@ public:
 
   int GetHistoryIndex();
 
+  std::deque<std::unique_ptr<UndoCommand>> const &undoCommands() const;
+
+  std::deque<std::unique_ptr<UndoCommand>> const &redoCommands() const;
+
+  /// Approximate bytes held by the undo and redo history.
+  std::size_t historyMemoryUsage() const;
+
+  std::size_t historyMemoryLimit() const;
+
+  /// The most recent command is always kept, even if it exceeds the limit alone.
+  void setHistoryMemoryLimit(std::size_t bytes);
+
   void deleteSelectedNodes();
   
   QJsonObject selectionToJson(bool includePartialConnections=false);
+
+  QJsonObject selectionToJson(QList<QGraphicsItem*> const &items, bool includePartialConnections=false);
   
   void jsonToScene(QJsonObject object);
   
@@ -166,6 +223,47 @@ public:
   
   void deleteJsonElements(const QJsonObject &object);
 
+  /// Copies the selected nodes, groups and connections into a
+  /// self-contained fragment. Models are cloned, nothing is serialized.
+  std::shared_ptr<SceneFragment> copyFragment() const;
+
+  /// Inserts new copies of the fragment centred on `mousePos` as one
+  /// history step and returns the created nodes. The history entry
+  /// shares the fragment instead of copying it.
+  std::vector<Node*> pasteFragment(std::shared_ptr<SceneFragment const> fragment, QPointF mousePos);
+
+  /// Creates the fragment elements moved by `offset`, outside of the
+  /// history. Nodes take the ids in `nodeIds` unless it is empty. The ids
+  /// of the created groups are written to `groupIds`.
+  std::vector<Node*> instantiateFragment(SceneFragment const &fragment,
+                                         QPointF offset,
+                                         std::vector<QUuid> const &nodeIds,
+                                         std::vector<QUuid> &groupIds);
+
+  /// While suspended, data reaching a node input is held back and only
+  /// the latest value per input is kept. The last resumePropagation
+  /// delivers it to every node still in the scene, sources first, so a
+  /// node outside of a cycle only sees the final values. Only the nodes
+  /// downstream of held back data are ordered. Calls nest.
+  void suspendPropagation();
+
+  void resumePropagation();
+
+  bool isPropagationSuspended() const;
+
+  /// True if data for `node` has to go through deferPropagation, the
+  /// node being delivered to by resumePropagation is exempt.
+  bool defersPropagationTo(Node const &node) const;
+
+  /// Used by Node::propagateData while propagation is suspended.
+  void deferPropagation(Node const &node,
+                        std::shared_ptr<NodeData> nodeData,
+                        PortIndex inPortIndex);
+
+  /// Timeline of Node::propagateData calls, see PropagationTrace.
+  PropagationTrace &
+  propagationTrace();
+
 signals:
 
   void nodeCreated(Node &n);
@@ -222,10 +320,66 @@ private:
   std::shared_ptr<DataModelRegistry>          _registry;
   std::unordered_map<QUuid, std::shared_ptr<Group>> _groups;
 
+  PropagationTrace _propagationTrace;
+
   bool writeToHistory; 
+
+  std::deque<std::unique_ptr<UndoCommand>> _undoCommands;
+  std::deque<std::unique_ptr<UndoCommand>> _redoCommands;
+
+  std::size_t _historyMemory;
+  std::size_t _historyMemoryLimit;
+
+  int _propagationSuspended;
+  std::map<std::pair<QUuid, PortIndex>, std::shared_ptr<NodeData>> _pendingPropagation;
+
+  // Receives its held back inputs in resumePropagation
+  Node const *_deliveringNode;
+
+  // Nodes whose connections wait for flushConnectionUpdates
+  std::unordered_set<QUuid> _connectionUpdateNodes;
+  QTimer _connectionUpdateTimer;
+
+  // Union of everything expandSceneRect has seen, the scene rect only grows
+  QRectF _contentBounds;
+  QTimer _sceneRectTimer;
+
+  // Items of the drag in progress and their start positions (x, y pairs)
+  std::vector<QUuid> _gestureGroupIds;
+  std::vector<QUuid> _gestureNodeIds;
+  std::vector<qreal> _gestureStartPositions;
+
+  // Sequence number of the drag in progress, its moves merge only with each other
+  quint64 _moveGesture = 0;
+
+  // Direct parent group of the grouped nodes and groups, by id
+  std::unordered_map<QUuid, Group*> _nodeGroups;
+  std::unordered_map<QUuid, Group*> _groupParents;
+
+  // Typed copy of selectedItems(), see updateSelection
+  mutable bool _selectionValid;
+  mutable std::vector<Node*> _selectedNodes;
+  mutable std::vector<Connection*> _selectedConnections;
+  mutable std::vector<Group*> _selectedGroups;
   
 
 private: 
+
+  void invalidateSelection();
+
+  /// Updates the group hierarchy after `item` was reparented.
+  void syncItemGroup(QGraphicsItem *item);
+
+  void setNodeGroup(Node& node, Group* group);
+
+  void setParentGroup(Group& group, Group* parent);
+
+  void updateSelection() const;
+
+  QJsonObject selectionToJson(std::vector<Node*> const &nodes,
+                              std::vector<Connection*> const &connections,
+                              std::vector<Group*> const &groups,
+                              bool includePartialConnections);
 };
 
 Node*
@@ -1,14 +1,24 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
+#include <QtCore/QMap>
 #include <QtWidgets/QGraphicsView>
 
 #include "Export.hpp"
+
+class QLineEdit;
+class QMenu;
+class QTreeWidgetItem;
   
 namespace QtNodes
 {
 
 class FlowScene;
+class DataModelRegistry;
 class NodeGraphicsObject;
+struct SceneFragment;
 
 class NODE_EDITOR_PUBLIC FlowView
   : public QGraphicsView
@@ -76,6 +86,16 @@ protected:
 
   FlowScene * scene();
 
+private:
+
+  QPointF mouseScenePos() const;
+
+  /// Builds the model menu, or rebuilds it after the registry changed.
+  void updateModelMenu();
+
+  /// Shows the menu entries matching `text`, see ModelPalette::search.
+  void filterModelMenu(QString const &text);
+
 private:
 
   QAction* _clearSelectionAction;
@@ -90,6 +110,20 @@ private:
 
   QPointF _clickPos;
 
+  // Model menu, kept between right clicks
+  QMenu* _modelMenu;
+  QLineEdit* _modelMenuFilter;
+  QMap<QString, QTreeWidgetItem*> _modelMenuCategories;
+  std::vector<QTreeWidgetItem*> _modelMenuItems;   // by palette entry id
+  DataModelRegistry const* _modelMenuRegistry;
+  quint64 _modelMenuRevision;
+  QPointF _modelMenuScenePos;
+
+  /// Last copied elements, pasted without going through the clipboard
+  /// as long as the clipboard holds `_clipboardToken`.
+  std::shared_ptr<SceneFragment const> _clipboardFragment;
+  QByteArray _clipboardToken;
+
   FlowScene* _scene;
 };
 }
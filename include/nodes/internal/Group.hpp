@@ -1,7 +1,9 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
+#include <unordered_set>
 
 #include <QtCore/QObject>
 #include <QtCore/QUuid>
@@ -24,6 +26,8 @@ namespace QtNodes
 {
 
 class GroupGraphicsObject;
+class GroupEvaluator;
+class Connection;
 
 class NODE_EDITOR_PUBLIC Group
     : public QObject
@@ -41,27 +45,61 @@ public:
       return *_groupGraphicsObject.get();
   }
 
-  Group(FlowScene &scene): _scene(scene),
-                          _id(QUuid::createUuid()),
-                          _groupGraphicsObject(nullptr),
-                          _name("New Group")
-  {  
+  Group(FlowScene &scene);
 
-  }
+  /// Nodes directly inside the group.
+  std::unordered_set<Node*> const &
+  nodes() const { return _nodes; }
 
-  void AddNode(std::shared_ptr<Node> node) {
-    nodes.push_back(node);
-  }
+  /// Groups directly nested in this one.
+  std::unordered_set<Group*> const &
+  childGroups() const { return _childGroups; }
+
+  /// Connections attached to the nodes of the group. PortType::In gives
+  /// the ones entering the group, PortType::Out the ones leaving it and
+  /// PortType::None the ones with both ends inside.
+  std::unordered_set<Connection*> const &
+  connections(PortType portType) const { return _connections[(int)portType]; }
+
+  // Membership is maintained by FlowScene, see FlowScene::nodeGroup
+  void addNode(Node *node);
+  void removeNode(Node *node);
+
+  void addChildGroup(Group *group) { _childGroups.insert(group); }
+  void removeChildGroup(Group *group) { _childGroups.erase(group); }
+
+  void addConnection(Connection *connection, PortType portType);
+  void removeConnection(Connection *connection, PortType portType);
+
+  /// A compiled group runs as one composite node while it is collapsed,
+  /// see GroupEvaluator.
+  void setCompiled(bool compiled);
+
+  bool isCompiled() const { return _compiled; }
+
+  /// Evaluator of the collapsed, compiled group, nullptr otherwise or when
+  /// the group cannot be compiled. Rebuilt after the content changed.
+  GroupEvaluator* evaluator();
+
+  /// Drops the compiled evaluator, e.g. after the ports of a member node
+  /// were renumbered.
+  void invalidateEvaluator() { _evaluator.reset(); }
 
 
   void
-  setGraphicsObject(std::shared_ptr<GroupGraphicsObject> graphics) {
-    _groupGraphicsObject = graphics;
+  setGraphicsObject(std::unique_ptr<GroupGraphicsObject>&& graphics) {
+    _groupGraphicsObject = std::move(graphics);
+  }
+
+  /// Leaves the graphics object to its scene, see FlowScene::clearScene.
+  GroupGraphicsObject *
+  releaseGraphicsObject() {
+    return _groupGraphicsObject.release();
   }
 
 
   virtual
-  ~Group(){};
+  ~Group();
 
   void SetName(QString _name);
   QString GetName();
@@ -72,11 +110,16 @@ public:
   QUuid
   id() const;
 
+  /// Only before the group is added to the scene, see FlowScene::restoreGroup.
+  void setId(QUuid id) { _id = id; }
+
   QJsonObject save() const override{
     QJsonObject groupJson;
+    groupJson["id"] = _id.toString();
     groupJson["name"] = _name;
     bool collapsed = _groupGraphicsObject->isCollapsed();
     groupJson["collapsed"] = (int)collapsed;
+    groupJson["compiled"] = (int)_compiled;
 
     QJsonObject posObj;
     posObj["x"] = _groupGraphicsObject->pos().x();
@@ -100,12 +143,18 @@ public:
 
   void restoreAtPosition(QJsonObject const &json, QPointF position);
 
-  std::shared_ptr<GroupGraphicsObject> _groupGraphicsObject;
+  std::unique_ptr<GroupGraphicsObject> _groupGraphicsObject;
   QString _name;
 private:
 
     FlowScene & _scene;
-    std::vector<std::shared_ptr<Node>> nodes;
+
+    std::unordered_set<Node*> _nodes;
+    std::unordered_set<Group*> _childGroups;
+    std::array<std::unordered_set<Connection*>, 3> _connections;
+
+    bool _compiled;
+    std::unique_ptr<GroupEvaluator> _evaluator;
 
     QUuid _id;
 };
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "PortType.hpp"
+#include "Export.hpp"
+
+namespace QtNodes
+{
+
+class Connection;
+class Group;
+class Node;
+class NodeData;
+
+/// Runs the nodes of a collapsed group as one composite node.
+///
+/// The inner nodes are put in dependency order once, when the evaluator
+/// is built. Data reaching the group is then pushed through that order
+/// directly: the signals of the inner models are blocked, their results
+/// are pulled with outData and nothing inside the group is repainted.
+/// Only the connections leaving the group carry data on, through the
+/// usual Connection::propagateData.
+///
+/// Models that emit dataUpdated later on, e.g. after computing in a
+/// thread, do not fit this scheme and should not be used in compiled
+/// groups. Groups with an inner cycle cannot be compiled, see isValid.
+class NODE_EDITOR_PUBLIC GroupEvaluator
+{
+public:
+
+  /// Compiles the current content of `group`.
+  explicit
+  GroupEvaluator(Group const &group);
+
+  /// False if the inner nodes have no dependency order.
+  bool
+  isValid() const { return _valid; }
+
+  /// Delivers `nodeData` to the input of `node`, one of the group nodes,
+  /// and evaluates every inner node depending on it.
+  void
+  propagate(Node const &node,
+            std::shared_ptr<NodeData> nodeData,
+            PortIndex inPortIndex);
+
+private:
+
+  struct Input
+  {
+    PortIndex inPort;
+    std::size_t sourceStep;
+    PortIndex sourcePort;
+  };
+
+  struct Step
+  {
+    Node *node;
+
+    /// Inputs fed by other inner nodes.
+    std::vector<Input> inputs;
+
+    /// Connections leaving the group, by output port.
+    std::vector<std::pair<PortIndex, Connection*>> outputs;
+  };
+
+  bool _valid;
+
+  std::vector<Step> _steps;
+
+  std::unordered_map<Node const*, std::size_t> _stepIndices;
+
+  // Steps evaluated by the current propagate call, kept to reuse the memory
+  std::vector<char> _dirty;
+};
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <QtCore/QString>
+
+#include "Export.hpp"
+#include "QStringStdHash.hpp"
+
+namespace QtNodes
+{
+
+/// Search index over the models and templates of a DataModelRegistry,
+/// filled as they get registered.
+///
+/// Names are indexed by their lower case trigrams, a query only checks
+/// the entries sharing its rarest trigram instead of every name. A sorted
+/// copy of the names serves prefix lookups.
+class NODE_EDITOR_PUBLIC ModelPalette
+{
+public:
+
+  struct Entry
+  {
+    QString name;
+    QString category;
+    bool isTemplate;
+
+    /// Removed entries keep their id, see entries().
+    bool removed;
+  };
+
+public:
+
+  void
+  addEntry(QString const &name, QString const &category, bool isTemplate);
+
+  void
+  removeEntry(QString const &name, bool isTemplate);
+
+  /// All the entries ever added, an entry id is its index here.
+  std::vector<Entry> const &
+  entries() const { return _entries; }
+
+  /// Changes on every addition or removal.
+  quint64
+  revision() const { return _revision; }
+
+  /// Ids of the entries whose name contains `text`, ignoring case, the
+  /// ones starting with it first. If no name contains `text`, returns the
+  /// names sharing at least half of its trigrams, best matches first.
+  std::vector<std::size_t>
+  search(QString const &text) const;
+
+private:
+
+  /// Three UTF-16 code units packed together.
+  using Trigram = quint64;
+
+  /// Distinct trigrams of `lowerName`.
+  static std::vector<Trigram>
+  trigrams(QString const &lowerName);
+
+private:
+
+  std::vector<Entry> _entries;
+
+  std::vector<QString> _lowerNames;
+
+  std::unordered_map<QString, std::size_t> _modelIds;
+  std::unordered_map<QString, std::size_t> _templateIds;
+
+  std::unordered_map<Trigram, std::vector<std::size_t>> _trigramIndex;
+
+  std::set<std::pair<QString, std::size_t>> _sortedNames;
+
+  quint64 _revision = 0;
+};
+}
@@ -16,6 +16,7 @@
 #include "NodeGraphicsObject.hpp"
 #include "ConnectionGraphicsObject.hpp"
 #include "Serializable.hpp"
+#include "BlockPool.hpp"
 
 namespace QtNodes
 {
@@ -40,6 +41,13 @@ public:
   virtual
   ~Node();
 
+  /// Nodes come from a BlockPool, scenes create and clear them in bulk.
+  static void*
+  operator new(std::size_t size) { return BlockPool::allocate(size); }
+
+  static void
+  operator delete(void *p, std::size_t size) { BlockPool::deallocate(p, size); }
+
 public:
 
   QJsonObject
@@ -84,6 +92,10 @@ public:
   void
   setGraphicsObject(std::unique_ptr<NodeGraphicsObject>&& graphics);
 
+  /// Leaves the graphics object to its scene, see FlowScene::clearScene.
+  NodeGraphicsObject *
+  releaseGraphicsObject();
+
   NodeGeometry&
   nodeGeometry();
 
@@ -99,6 +111,8 @@ public:
   NodeDataModel*
   nodeDataModel() const;
 
+  /// Rebuilds the ports and the geometry from scratch, see insertPort and
+  /// removePort for single ports.
   void
   updateView();
 
@@ -129,6 +143,33 @@ public slots: // data propagation
   void
   onDataUpdatedConnection(PortIndex index, Connection* connection);
 
+  /// Recomputes the geometry after NodeDataModel::layoutChanged.
+  void
+  onLayoutChanged();
+
+public slots: // dynamic ports
+
+  /// Takes in a port the model has just inserted at `portIndex`. The
+  /// connections of the later ports are renumbered in place and only the
+  /// new port label is measured.
+  void
+  insertPort(PortType portType, PortIndex portIndex);
+
+  /// Deletes the connections of a port the model is about to remove.
+  void
+  erasePortConnections(PortType portType, PortIndex portIndex);
+
+  /// Drops a port the model has just removed, the connections of the
+  /// later ports are renumbered in place. Its connections must have been
+  /// deleted by erasePortConnections while the model still had it.
+  void
+  removePort(PortType portType, PortIndex portIndex);
+
+private:
+
+  void
+  onPortsRenumbered();
+
 private:
 
   // addressing
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <type_traits>
+#include <utility>
+
 #include <QtCore/QString>
 
+#include "TypeRegistry.hpp"
 #include "Export.hpp"
 
 namespace QtNodes
@@ -9,10 +13,46 @@ namespace QtNodes
 
 struct NodeDataType
 {
-  QString id;
+  NodeDataType() = default;
+
+  NodeDataType(QString typeId, QString typeName)
+    : name(std::move(typeName))
+    , _id(std::move(typeId))
+    , _handle(TypeRegistry::intern(_id))
+  {}
+
+  /// Read-only, a type with another id is a new NodeDataType.
+  QString const &
+  id() const { return _id; }
+
+  /// Interned id(), types are compared through it.
+  TypeHandle
+  handle() const { return _handle; }
+
   QString name;
+
+private:
+
+  QString _id;
+
+  TypeHandle _handle = 0;
 };
 
+
+inline bool
+operator==(NodeDataType const &a, NodeDataType const &b)
+{
+  return a.handle() == b.handle();
+}
+
+
+inline bool
+operator!=(NodeDataType const &a, NodeDataType const &b)
+{
+  return a.handle() != b.handle();
+}
+
+
 /// Class represents data transferred between nodes.
 /// @param type is used for comparing the types
 /// The actual data is stored in subtypes
@@ -24,10 +64,27 @@ public:
 
   virtual bool sameType(NodeData const &nodeData) const
   {
-    return (this->type().id == nodeData.type().id);
+    return (this->type() == nodeData.type());
   }
 
   /// Type for inner use
   virtual NodeDataType type() const = 0;
 };
+
+
+/// Type of the NodeData subclass `DataType`, built and interned once.
+/// Models can return it from dataType() instead of a new NodeDataType
+/// on every call:
+///
+///   return dataTypeOf<DecimalData>();
+template<typename DataType>
+NodeDataType const &
+dataTypeOf()
+{
+  static_assert(std::is_base_of<NodeData, DataType>::value,
+                "Must pass a subclass of NodeData to dataTypeOf");
+
+  static NodeDataType const type = DataType().type();
+  return type;
+}
 }
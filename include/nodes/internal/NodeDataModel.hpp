@@ -10,6 +10,7 @@
 #include "NodeGeometry.hpp"
 #include "NodeStyle.hpp"
 #include "NodePainterDelegate.hpp"
+#include "BlockPool.hpp"
 #include "Export.hpp"
 
 namespace QtNodes
@@ -37,6 +38,14 @@ public:
   virtual
   ~NodeDataModel() = default;
 
+  /// Models of every subclass come from a BlockPool, loading a scene or
+  /// undoing a deletion creates them in bulk.
+  static void*
+  operator new(std::size_t size) { return BlockPool::allocate(size); }
+
+  static void
+  operator delete(void *model, std::size_t size) { BlockPool::deallocate(model, size); }
+
   /// Caption is used in GUI
   virtual QString
   caption() const = 0;
@@ -91,15 +100,24 @@ public:
     return ConnectionPolicy::Many;
   }
 
+  /// The style set on this model, or the current StyleCollection one,
+  /// which then also applies after a theme switch.
   NodeStyle const&
   nodeStyle() const;
 
+  /// Gives the model a private copy of `style`.
   void
   setNodeStyle(NodeStyle const& style);
 
+  /// Shares `style` with other models, nullptr goes back to the
+  /// StyleCollection style.
+  void
+  setNodeStyle(std::shared_ptr<NodeStyle const> style);
+
 public:
 
-  /// Triggers the algorithm
+  /// Triggers the algorithm. Data too large to pass at once can come as
+  /// a StreamData, whose chunks are then read as they arrive.
   virtual
   void
   setInData(std::shared_ptr<NodeData> nodeData,
@@ -146,6 +164,28 @@ signals:
 
   void
   computingFinished();
+
+  /// Emit when a port caption or the size of the embedded widget changes,
+  /// or the caption or validation message outside of setInData. The node
+  /// measures its text again.
+  void
+  layoutChanged();
+
+  /// Emit after adding a port at `index`, Node::insertPort keeps the
+  /// existing connections and measures only the new port.
+  void
+  portInserted(PortType portType, PortIndex index);
+
+  /// Emit before removing the port at `index`, its connections are
+  /// deleted while the data can still reach it. Mandatory before
+  /// portRemoved, which expects the port to be unconnected.
+  void
+  portAboutToBeRemoved(PortType portType, PortIndex index);
+
+  /// Emit after removing the port at `index`, always preceded by
+  /// portAboutToBeRemoved.
+  void
+  portRemoved(PortType portType, PortIndex index);
   
   void setToolTipTextSignal(QString text);
   
@@ -154,6 +194,7 @@ private:
 
 	QString _toolTipText;
 	
-  NodeStyle _nodeStyle;
+  // Null unless customized, most models share the collection style
+  std::shared_ptr<NodeStyle const> _nodeStyle;
 };
 }
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <array>
 #include <memory>
+#include <vector>
 
 #include <QtCore/QRectF>
 #include <QtCore/QPointF>
 #include <QtGui/QTransform>
+#include <QtGui/QFont>
 #include <QtGui/QFontMetrics>
 
 #include "PortType.hpp"
@@ -17,6 +20,23 @@ class NodeState;
 class NodeDataModel;
 class Node;
 
+/// Metrics of a font and of its bold variant. Nodes drawn with the same
+/// font share one instance instead of each holding its own metrics.
+struct NODE_EDITOR_PUBLIC NodeFontMetrics
+{
+  explicit
+  NodeFontMetrics(QFont const &font);
+
+  QFont font;
+
+  QFontMetrics metrics;
+  QFontMetrics boldMetrics;
+
+  /// The shared metrics of `font`, built on first use. GUI thread only.
+  static std::shared_ptr<NodeFontMetrics const>
+  forFont(QFont const &font);
+};
+
 class NODE_EDITOR_PUBLIC NodeGeometry
 {
 public:
@@ -82,11 +102,28 @@ public:
   QRectF
   boundingRect() const;
 
-  /// Updates size unconditionally
+  /// Measures the caption, port labels and validation message again and
+  /// updates the size. Call it whenever one of them, the port count or the
+  /// embedded widget size changes; painting only reads the results.
   void
   recalculateSize() const;
 
-  /// Updates size if the QFontMetrics is changed
+  /// Measures the label of a port the model has just inserted at `index`
+  /// and updates the size, the other labels are kept.
+  void
+  insertPort(PortType portType, PortIndex index);
+
+  /// Forgets the label of a port the model has just removed.
+  void
+  removePort(PortType portType, PortIndex index);
+
+  /// Lays out the node from the measurements taken so far, only the
+  /// validation message is measured. Enough after the validation state
+  /// or message changed.
+  void
+  updateSize() const;
+
+  /// Updates size if `font` differs from the one last measured with
   void
   recalculateSize(QFont const &font) const;
 
@@ -108,8 +145,19 @@ public:
   QPointF
   widgetPosition() const;
 
+  /// Caption bounds in the bold font, empty if the caption is hidden.
+  QRect const &
+  captionRect() const { return _captionRect; }
+
+  /// Port caption, or data type name if the caption is hidden.
+  QString const &
+  portLabel(PortType portType, PortIndex index) const;
+
+  QRect
+  portLabelRect(PortType portType, PortIndex index) const;
+
   unsigned int
-  validationHeight() const;
+  validationHeight() const { return _validationHeight; }
 
   unsigned int
   validationWidth() const;
@@ -122,13 +170,24 @@ public:
 private:
 
   unsigned int
-  captionHeight() const;
+  captionHeight() const { return _captionRect.height(); }
 
   unsigned int
-  captionWidth() const;
+  captionWidth() const { return _captionRect.width(); }
 
+  /// Height of the validation message wrapped to a node `width` wide.
   unsigned int
-  portWidth(PortType portType) const;
+  measureValidationHeight(unsigned int width) const;
+
+  struct PortLabel
+  {
+    QString text;
+    QRect rect;
+    int width = 0;
+  };
+
+  PortLabel
+  measurePortLabel(PortType portType, PortIndex index) const;
 
 private:
 
@@ -154,7 +213,18 @@ private:
 
   std::unique_ptr<NodeDataModel> const &_dataModel;
 
-  mutable QFontMetrics _fontMetrics;
-  mutable QFontMetrics _boldFontMetrics;
+  // Text measurements, updated by recalculateSize
+  mutable QRect _captionRect;
+  mutable std::array<std::vector<PortLabel>, 3> _portLabels;
+  mutable unsigned int _validationHeight = 0;
+
+  // Last validation message measured and the node width it was wrapped
+  // to, with the results
+  mutable QString _validationMessage;
+  mutable unsigned int _validationWrapWidth = 0;
+  mutable unsigned int _validationWidth = 0;
+  mutable unsigned int _validationWrappedHeight = 0;
+
+  mutable std::shared_ptr<NodeFontMetrics const> _fontMetrics;
 };
 }
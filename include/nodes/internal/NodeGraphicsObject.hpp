@@ -7,6 +7,7 @@
 
 #include "NodeGeometry.hpp"
 #include "NodeState.hpp"
+#include "BlockPool.hpp"
 
 class QGraphicsProxyWidget;
 
@@ -29,6 +30,13 @@ public:
   virtual
   ~NodeGraphicsObject();
 
+  /// Allocated from a BlockPool, like Node.
+  static void*
+  operator new(std::size_t size) { return BlockPool::allocate(size); }
+
+  static void
+  operator delete(void *p, std::size_t size) { BlockPool::deallocate(p, size); }
+
   Node&
   node();
 
@@ -49,6 +57,11 @@ public:
   void
   moveConnections() const;
 
+  /// Same as moveConnections, deferred to the next
+  /// FlowScene::flushConnectionUpdates.
+  void
+  scheduleMoveConnections() const;
+
   enum { Type = UserType + 1 };
 
   int
@@ -8,6 +8,7 @@
 
 #include "PortType.hpp"
 #include "NodeData.hpp"
+#include "QUuidStdHash.hpp"
 
 namespace QtNodes
 {
@@ -64,6 +65,16 @@ public:
   void
   eraseInputAtIndex(PortIndex portIndex);
 
+  /// Adds an empty entry at `portIndex`. The connections of the later
+  /// ports are renumbered in place.
+  void
+  insertPort(PortType portType, PortIndex portIndex);
+
+  /// Drops the entry at `portIndex`, which must have no connections
+  /// left. The connections of the later ports are renumbered in place.
+  void
+  removePort(PortType portType, PortIndex portIndex);
+
   ReactToConnectionState
   reaction() const;
 
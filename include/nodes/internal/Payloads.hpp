@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <QtCore/QString>
+#include <QtGui/QImage>
+
+#include "NodeData.hpp"
+
+namespace QtNodes
+{
+
+/// Reference counted array of values that is never modified while shared.
+///
+/// Copies share the values, so data fanned out to any number of nodes is
+/// never duplicated. Writing goes through detach, which copies the values
+/// first if anybody else still holds them (explicit copy-on-write).
+template<typename T>
+class SharedBuffer
+{
+public:
+
+  SharedBuffer() = default;
+
+  explicit
+  SharedBuffer(std::vector<T> values)
+    : _values(std::make_shared<std::vector<T>>(std::move(values)))
+  {}
+
+  std::size_t
+  size() const { return _values ? _values->size() : 0; }
+
+  bool
+  empty() const { return size() == 0; }
+
+  T const *
+  data() const { return _values ? _values->data() : nullptr; }
+
+  T const &
+  operator[](std::size_t i) const { return (*_values)[i]; }
+
+  T const *
+  begin() const { return data(); }
+
+  T const *
+  end() const { return data() + size(); }
+
+  /// True if other buffers refer to the same values.
+  bool
+  isShared() const { return _values && _values.use_count() > 1; }
+
+  /// Values for writing, copied first if they are shared. Must not race
+  /// with copies of this very object made on other threads.
+  std::vector<T> &
+  detach()
+  {
+    if (!_values)
+      _values = std::make_shared<std::vector<T>>();
+    else if (_values.use_count() > 1)
+      _values = std::make_shared<std::vector<T>>(*_values);
+
+    return *_values;
+  }
+
+private:
+
+  std::shared_ptr<std::vector<T>> _values;
+};
+
+
+/// Type id and name of ArrayData<T>, defined for the usual numeric types.
+template<typename T>
+struct ArrayTypeTraits;
+
+template<>
+struct ArrayTypeTraits<double>
+{
+  static char const * id()   { return "qtnodes.array<double>"; }
+  static char const * name() { return "Doubles"; }
+};
+
+template<>
+struct ArrayTypeTraits<float>
+{
+  static char const * id()   { return "qtnodes.array<float>"; }
+  static char const * name() { return "Floats"; }
+};
+
+template<>
+struct ArrayTypeTraits<qint32>
+{
+  static char const * id()   { return "qtnodes.array<int32>"; }
+  static char const * name() { return "Integers"; }
+};
+
+template<>
+struct ArrayTypeTraits<qint64>
+{
+  static char const * id()   { return "qtnodes.array<int64>"; }
+  static char const * name() { return "Long Integers"; }
+};
+
+template<>
+struct ArrayTypeTraits<quint8>
+{
+  static char const * id()   { return "qtnodes.array<uint8>"; }
+  static char const * name() { return "Bytes"; }
+};
+
+
+/// Contiguous numeric values.
+template<typename T>
+class ArrayData : public NodeData
+{
+public:
+
+  ArrayData() = default;
+
+  explicit
+  ArrayData(SharedBuffer<T> values)
+    : _values(std::move(values))
+  {}
+
+  NodeDataType
+  type() const override
+  {
+    static NodeDataType const type{ ArrayTypeTraits<T>::id(),
+                                    ArrayTypeTraits<T>::name() };
+    return type;
+  }
+
+  SharedBuffer<T> const &
+  values() const { return _values; }
+
+private:
+
+  SharedBuffer<T> _values;
+};
+
+
+/// Image, QImage already shares its pixels and copies them on write.
+class ImageData : public NodeData
+{
+public:
+
+  ImageData() = default;
+
+  explicit
+  ImageData(QImage image)
+    : _image(std::move(image))
+  {}
+
+  NodeDataType
+  type() const override
+  {
+    static NodeDataType const type{ "qtnodes.image", "Image" };
+    return type;
+  }
+
+  QImage const &
+  image() const { return _image; }
+
+private:
+
+  QImage _image;
+};
+
+
+/// Named columns of numbers, each one a SharedBuffer. Tables derived
+/// from another one share the columns they keep.
+class TableData : public NodeData
+{
+public:
+
+  TableData() = default;
+
+  TableData(std::vector<QString> columnNames,
+            std::vector<SharedBuffer<double>> columns)
+    : _columnNames(std::move(columnNames))
+    , _columns(std::move(columns))
+  {}
+
+  NodeDataType
+  type() const override
+  {
+    static NodeDataType const type{ "qtnodes.table", "Table" };
+    return type;
+  }
+
+  std::size_t
+  columnCount() const { return _columns.size(); }
+
+  /// Length of the shortest column.
+  std::size_t
+  rowCount() const
+  {
+    if (_columns.empty())
+      return 0;
+
+    std::size_t rows = _columns.front().size();
+    for (auto const &column : _columns)
+      rows = std::min(rows, column.size());
+
+    return rows;
+  }
+
+  QString const &
+  columnName(std::size_t column) const { return _columnNames[column]; }
+
+  SharedBuffer<double> const &
+  column(std::size_t column) const { return _columns[column]; }
+
+private:
+
+  std::vector<QString> _columnNames;
+
+  std::vector<SharedBuffer<double>> _columns;
+};
+
+
+/// `nodeData` as a PayloadType, or nullptr if it holds another type.
+///
+/// Compares the interned type handles instead of using RTTI, so the type
+/// id of PayloadType must not be used by any other NodeData subclass. The
+/// payloads above use ids prefixed with "qtnodes.", other types cast this
+/// way should use a prefix of their own. Debug builds check the cast
+/// anyway.
+template<typename PayloadType>
+std::shared_ptr<PayloadType>
+payload_cast(std::shared_ptr<NodeData> const &nodeData)
+{
+  if (nodeData && nodeData->type() == dataTypeOf<PayloadType>())
+  {
+    Q_ASSERT(dynamic_cast<PayloadType*>(nodeData.get()));
+    return std::static_pointer_cast<PayloadType>(nodeData);
+  }
+
+  return nullptr;
+}
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonObject>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QUuid>
+
+#include "PortType.hpp"
+#include "Export.hpp"
+
+namespace QtNodes
+{
+
+class Node;
+
+/// Records a timeline of data propagation events of a FlowScene.
+/// Every call of Node::propagateData becomes one event with its node,
+/// port, start and end timestamps and the thread it ran on.
+/// The timeline can be exported in the Chrome Trace Event format and
+/// opened in chrome://tracing or https://ui.perfetto.dev.
+class NODE_EDITOR_PUBLIC PropagationTrace
+{
+public:
+
+  struct Event
+  {
+    QUuid     nodeId;
+    QString   modelName;
+    PortIndex portIndex;
+    bool      emptyData;
+    qint64    startUs;
+    qint64    endUs;
+    quint64   threadId;
+    bool      guiThread;
+  };
+
+  /// Measures the lifetime of one propagation and stores it
+  /// in the trace on destruction. Does nothing if recording is off.
+  class NODE_EDITOR_PUBLIC Scope
+  {
+  public:
+
+    Scope(PropagationTrace &trace,
+          Node const &node,
+          PortIndex portIndex,
+          bool emptyData);
+
+    ~Scope();
+
+    Scope(Scope const &) = delete;
+    Scope& operator=(Scope const &) = delete;
+
+  private:
+
+    PropagationTrace &_trace;
+    Node const &_node;
+    PortIndex _portIndex;
+    bool _emptyData;
+    bool _active;
+    qint64 _startUs;
+  };
+
+public:
+
+  PropagationTrace();
+
+  PropagationTrace(PropagationTrace const &) = delete;
+  PropagationTrace& operator=(PropagationTrace const &) = delete;
+
+public:
+
+  /// Starts recording. Previously recorded events are kept.
+  void
+  start();
+
+  void
+  stop();
+
+  bool
+  isRecording() const { return _recording; }
+
+  /// Drops all the events and restarts the clock.
+  void
+  clear();
+
+  /// Returns a copy of the recorded events, safe to call while recording.
+  std::vector<Event>
+  events() const;
+
+  /// Microseconds since the trace clock was (re)started.
+  qint64
+  now() const;
+
+  void
+  addEvent(Event const &event);
+
+public:
+
+  /// Builds a Chrome Trace Event document:
+  /// {"traceEvents": [...], "displayTimeUnit": "ms"}
+  QJsonObject
+  toChromeTrace() const;
+
+  bool
+  saveChromeTrace(QString const &fileName) const;
+
+private:
+
+  std::atomic<bool> _recording;
+
+  // Started once and never restarted, clear() moves the epoch instead so
+  // now() stays safe on worker threads
+  QElapsedTimer _clock;
+
+  std::atomic<qint64> _epochNs;
+
+  mutable QMutex _mutex;
+
+  std::vector<Event> _events;
+};
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QPointF>
+
+#include "PortType.hpp"
+#include "NodeDataModel.hpp"
+#include "Export.hpp"
+
+namespace QtNodes
+{
+
+class DataModelRegistry;
+
+/// Nodes, connections and groups copied out of a FlowScene or read from
+/// a template, see FlowScene::copyFragment and FlowScene::pasteFragment.
+///
+/// The models are clones holding the copied state, so a fragment stays
+/// valid after the originals are edited or deleted. A fragment is never
+/// modified once built and can be shared by any number of insertions.
+/// Connections refer to nodes by their index in `models`, no ids have
+/// to be remapped.
+struct NODE_EDITOR_PUBLIC SceneFragment
+{
+  struct ConnectionEntry
+  {
+    int outNode;
+    PortIndex outPort;
+    int inNode;
+    PortIndex inPort;
+  };
+
+  std::vector<std::unique_ptr<NodeDataModel>> models;
+
+  /// Scene position of every model.
+  std::vector<QPointF> positions;
+
+  std::vector<ConnectionEntry> connections;
+
+  /// Groups in the Group::save format, they are few and cheap to restore.
+  QJsonArray groups;
+
+  /// Builds a fragment from a document in the FlowScene::selectionToJson
+  /// format. Nodes whose model is unknown to `registry` are left out,
+  /// together with their connections.
+  static std::shared_ptr<SceneFragment>
+  fromJson(QJsonObject const &json, DataModelRegistry &registry);
+
+  /// The fragment in the FlowScene::selectionToJson format, with new node
+  /// ids. Saves every model, only for handing the fragment out of process.
+  QJsonObject
+  toJson() const;
+};
+}
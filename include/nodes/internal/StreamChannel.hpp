@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QWaitCondition>
+
+#include "NodeData.hpp"
+#include "Export.hpp"
+
+namespace QtNodes
+{
+
+class StreamReader;
+
+/// Bounded queue of chunks going from one producer to any number of
+/// StreamReader, for data too large to wait for as a whole.
+///
+/// A producer creates a channel, hands it downstream once in a StreamData
+/// through the usual outData / dataUpdated, then pushes the chunks as they
+/// are computed and closes the channel. Consumers open a reader in
+/// setInData and drain it on chunkPushed, so a long chain works on the
+/// first chunks while the last ones are still being produced.
+///
+/// Every reader sees every chunk. A chunk is dropped once all readers are
+/// past it, the channel never holds more than `capacity` chunks: a full
+/// channel refuses tryPush and blocks push until the slowest reader
+/// catches up. Until a reader is opened the chunks are kept, readers
+/// opened before the channel fills up see the stream from its start.
+/// Destroying the last reader closes the channel, which tells the producer
+/// to stop.
+///
+/// Safe to use from any thread. The signals are emitted from the thread
+/// pushing or reading, consumers living in another thread get them queued.
+class NODE_EDITOR_PUBLIC StreamChannel
+  : public QObject
+{
+  Q_OBJECT
+
+public:
+
+  StreamChannel(NodeDataType chunkType, std::size_t capacity = 16);
+
+  ~StreamChannel();
+
+  /// Type of every chunk in the stream.
+  NodeDataType const &
+  chunkType() const { return _chunkType; }
+
+  std::size_t
+  capacity() const { return _capacity; }
+
+  /// Chunks waiting for at least one reader.
+  std::size_t
+  size() const;
+
+  /// Appends `chunk` unless the channel is full or closed.
+  bool
+  tryPush(std::shared_ptr<NodeData> chunk);
+
+  /// Appends `chunk`, waiting for space if the channel is full. Only for
+  /// producers in a worker thread, the readers would never get to run if
+  /// it blocked their own thread. Returns false if the channel was closed.
+  bool
+  push(std::shared_ptr<NodeData> chunk);
+
+  /// Ends the stream, readers still get the chunks pushed so far.
+  void
+  close();
+
+  bool
+  isClosed() const;
+
+signals:
+
+  void
+  chunkPushed();
+
+  /// A full channel has room again.
+  void
+  spaceAvailable();
+
+  void
+  closed();
+
+private:
+
+  friend class StreamReader;
+
+  /// Drops the chunks read by every reader, must hold `_mutex`. Returns
+  /// true if that made room in a full channel.
+  bool
+  trim();
+
+private:
+
+  NodeDataType const _chunkType;
+
+  std::size_t const _capacity;
+
+  mutable QMutex _mutex;
+
+  QWaitCondition _notFull;
+
+  std::deque<std::shared_ptr<NodeData>> _chunks;
+
+  // Stream position of _chunks.front()
+  quint64 _firstPosition = 0;
+
+  std::vector<StreamReader*> _readers;
+
+  bool _closed = false;
+};
+
+
+/// Position of one consumer in a StreamChannel. The reader holds the
+/// chunks it has not read yet, destroying it releases them.
+class NODE_EDITOR_PUBLIC StreamReader
+{
+public:
+
+  explicit
+  StreamReader(std::shared_ptr<StreamChannel> channel);
+
+  ~StreamReader();
+
+  StreamReader(StreamReader const &) = delete;
+
+  StreamReader &
+  operator=(StreamReader const &) = delete;
+
+  std::shared_ptr<StreamChannel> const &
+  channel() const { return _channel; }
+
+  /// The next chunk, or nullptr if none was pushed yet.
+  std::shared_ptr<NodeData>
+  read();
+
+  /// True once the channel is closed and every chunk was read.
+  bool
+  atEnd() const;
+
+private:
+
+  friend class StreamChannel;
+
+  std::shared_ptr<StreamChannel> _channel;
+
+  // Guarded by the channel mutex
+  quint64 _position;
+};
+
+
+/// Hands a StreamChannel over a connection. Its type is derived from the
+/// chunk type, see streamType, so streams only connect to ports expecting
+/// the same chunks.
+class NODE_EDITOR_PUBLIC StreamData
+  : public NodeData
+{
+public:
+
+  explicit
+  StreamData(std::shared_ptr<StreamChannel> channel)
+    : _channel(std::move(channel))
+    , _type(streamType(_channel->chunkType()))
+  {}
+
+  NodeDataType
+  type() const override { return _type; }
+
+  std::shared_ptr<StreamChannel> const &
+  channel() const { return _channel; }
+
+  /// Port type of streams of `chunkType` chunks. Interns the id on every
+  /// call, models should keep the result rather than build it in dataType().
+  static NodeDataType
+  streamType(NodeDataType const &chunkType)
+  {
+    return NodeDataType(QStringLiteral("stream:") + chunkType.id(),
+                        chunkType.name + QStringLiteral(" stream"));
+  }
+
+private:
+
+  std::shared_ptr<StreamChannel> _channel;
+
+  NodeDataType _type;
+};
+}
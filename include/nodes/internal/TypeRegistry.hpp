@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QtCore/QString>
+
+#include "Export.hpp"
+
+namespace QtNodes
+{
+
+/// Small integer standing for a NodeDataType id, 0 for the empty id.
+using TypeHandle = quint32;
+
+/// Process-wide table of the data type ids seen so far.
+///
+/// Every distinct id gets a handle on its first interning and keeps it
+/// until the program exits, so two types are the same exactly when their
+/// handles are equal. Safe to use from any thread.
+class NODE_EDITOR_PUBLIC TypeRegistry
+{
+public:
+
+  static TypeHandle
+  intern(QString const &typeId);
+
+  /// The id `handle` was interned from, empty for unknown handles.
+  static QString
+  typeId(TypeHandle handle);
+};
+}
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QPointF>
+#include <QtCore/QString>
+#include <QtCore/QUuid>
+
+#include "PortType.hpp"
+#include "Export.hpp"
+
+namespace QtNodes
+{
+
+class FlowScene;
+struct SceneFragment;
+
+/// Legacy history entry made of two closures, see FlowScene::AddAction.
+struct UndoRedoAction {
+
+  std::function<int(void*)> undoAction;
+  std::function<int(void*)> redoAction;
+  QString name;
+  UndoRedoAction(std::function<int(void*)> undoAction, std::function<int(void*)> redoAction, const QString &name) {
+    this->undoAction = undoAction;
+    this->redoAction = redoAction;
+    this->name = name;
+  };
+};
+
+
+/// One entry of the FlowScene history.
+/// Commands keep the smallest state needed to replay themselves and
+/// refer to scene elements by id, never by pointer.
+class NODE_EDITOR_PUBLIC UndoCommand
+{
+public:
+
+  virtual
+  ~UndoCommand() = default;
+
+  virtual void
+  undo(FlowScene &scene) = 0;
+
+  virtual void
+  redo(FlowScene &scene) = 0;
+
+  virtual QString
+  name() const = 0;
+
+  /// Approximate number of bytes held by the command,
+  /// used to enforce the history memory limit.
+  virtual std::size_t
+  memoryUsage() const = 0;
+
+  /// Tries to fold `next`, recorded right after this command, into it.
+  /// Returns false if the commands have to stay separate.
+  virtual bool
+  mergeWith(UndoCommand const &next);
+};
+
+
+/// Wraps the closures of an UndoRedoAction.
+/// The captured state is opaque, only the closure objects are accounted.
+class NODE_EDITOR_PUBLIC ActionCommand : public UndoCommand
+{
+public:
+
+  ActionCommand(UndoRedoAction action);
+
+  void
+  undo(FlowScene &scene) override;
+
+  void
+  redo(FlowScene &scene) override;
+
+  QString
+  name() const override;
+
+  std::size_t
+  memoryUsage() const override;
+
+private:
+
+  UndoRedoAction _action;
+};
+
+
+/// Scene position change of a set of nodes and groups, typically
+/// everything moved by one drag gesture.
+class NODE_EDITOR_PUBLIC MoveCommand : public UndoCommand
+{
+public:
+
+  /// `positions` is flat, four values per item, groups first and then
+  /// nodes: old x, old y, new x, new y. All positions are scene positions.
+  /// Moves of the same items recorded for the same `gesture` are merged,
+  /// separate gestures stay separate however close in time.
+  MoveCommand(std::vector<QUuid> groupIds,
+              std::vector<QUuid> nodeIds,
+              std::vector<qreal> positions,
+              QString name,
+              quint64 gesture);
+
+  void
+  undo(FlowScene &scene) override;
+
+  void
+  redo(FlowScene &scene) override;
+
+  QString
+  name() const override;
+
+  std::size_t
+  memoryUsage() const override;
+
+  bool
+  mergeWith(UndoCommand const &next) override;
+
+  std::vector<QUuid> const &
+  groupIds() const { return _groupIds; }
+
+  std::vector<QUuid> const &
+  nodeIds() const { return _nodeIds; }
+
+  std::vector<qreal> const &
+  positions() const { return _positions; }
+
+private:
+
+  void
+  apply(FlowScene &scene, bool useNewPositions) const;
+
+private:
+
+  std::vector<QUuid> _groupIds;
+
+  std::vector<QUuid> _nodeIds;
+
+  std::vector<qreal> _positions;
+
+  QString _name;
+
+  quint64 _gesture;
+};
+
+
+/// Nodes (with their connections) and groups added to or removed from
+/// the scene. The elements are kept as one compressed JSON blob in the
+/// FlowScene::selectionToJson format, next to the ids of the nodes.
+class NODE_EDITOR_PUBLIC SceneDiffCommand : public UndoCommand
+{
+public:
+
+  enum class Kind
+  {
+    Added,
+    Removed
+  };
+
+public:
+
+  SceneDiffCommand(Kind kind, QJsonObject const &elements, QString name);
+
+  void
+  undo(FlowScene &scene) override;
+
+  void
+  redo(FlowScene &scene) override;
+
+  QString
+  name() const override;
+
+  std::size_t
+  memoryUsage() const override;
+
+  /// Decompresses the stored elements.
+  QJsonObject
+  elements() const;
+
+private:
+
+  void
+  insertElements(FlowScene &scene) const;
+
+  void
+  removeElements(FlowScene &scene) const;
+
+private:
+
+  Kind _kind;
+
+  QByteArray _blob;
+
+  std::vector<QUuid> _nodeIds;
+
+  std::vector<QUuid> _groupIds;
+
+  QString _name;
+};
+
+
+/// Elements instantiated from a SceneFragment, by a paste or a template.
+/// The fragment is shared with the clipboard or the registry, the command
+/// only holds the placement and the ids of what it created.
+class NODE_EDITOR_PUBLIC FragmentCommand : public UndoCommand
+{
+public:
+
+  FragmentCommand(std::shared_ptr<SceneFragment const> fragment,
+                  QPointF offset,
+                  std::vector<QUuid> nodeIds,
+                  std::vector<QUuid> groupIds,
+                  QString name);
+
+  void
+  undo(FlowScene &scene) override;
+
+  void
+  redo(FlowScene &scene) override;
+
+  QString
+  name() const override;
+
+  /// The shared fragment is not counted.
+  std::size_t
+  memoryUsage() const override;
+
+private:
+
+  std::shared_ptr<SceneFragment const> _fragment;
+
+  QPointF _offset;
+
+  std::vector<QUuid> _nodeIds;
+
+  // Groups get a new id each time they are created
+  std::vector<QUuid> _groupIds;
+
+  QString _name;
+};
+
+
+/// A single connection created or deleted by the user.
+class NODE_EDITOR_PUBLIC ConnectionCommand : public UndoCommand
+{
+public:
+
+  enum class Kind
+  {
+    Added,
+    Removed
+  };
+
+public:
+
+  ConnectionCommand(Kind kind,
+                    QUuid connectionId,
+                    QUuid nodeInId,
+                    PortIndex portIn,
+                    QUuid nodeOutId,
+                    PortIndex portOut);
+
+  void
+  undo(FlowScene &scene) override;
+
+  void
+  redo(FlowScene &scene) override;
+
+  QString
+  name() const override;
+
+  std::size_t
+  memoryUsage() const override;
+
+private:
+
+  void
+  insertConnection(FlowScene &scene) const;
+
+  void
+  removeConnection(FlowScene &scene) const;
+
+private:
+
+  Kind _kind;
+
+  QUuid _connectionId;
+
+  QUuid _nodeInId;
+  PortIndex _portIn;
+
+  QUuid _nodeOutId;
+  PortIndex _portOut;
+};
+}
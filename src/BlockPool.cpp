@@ -0,0 +1,99 @@
+#include "BlockPool.hpp"
+
+#include <mutex>
+#include <new>
+
+using QtNodes::BlockPool;
+
+namespace
+{
+
+std::size_t const Granularity  = 16;
+std::size_t const MaxBlockSize = 1024;
+std::size_t const ChunkSize    = 64 * 1024;
+
+struct FreeBlock
+{
+  FreeBlock *next;
+};
+
+struct SizeClass
+{
+  std::mutex mutex;
+
+  FreeBlock *freeList = nullptr;
+
+  // Unused part of the newest chunk
+  char *cursor = nullptr;
+  char *end    = nullptr;
+};
+
+
+SizeClass &
+sizeClass(std::size_t index)
+{
+  static SizeClass classes[MaxBlockSize / Granularity];
+  return classes[index];
+}
+}
+
+void*
+BlockPool::
+allocate(std::size_t size)
+{
+  if (size == 0)
+    size = 1;
+
+  if (size > MaxBlockSize)
+    return ::operator new(size);
+
+  std::size_t const index     = (size - 1) / Granularity;
+  std::size_t const blockSize = (index + 1) * Granularity;
+
+  SizeClass &sc = sizeClass(index);
+
+  std::lock_guard<std::mutex> lock(sc.mutex);
+
+  if (FreeBlock *block = sc.freeList)
+  {
+    sc.freeList = block->next;
+    return block;
+  }
+
+  if (static_cast<std::size_t>(sc.end - sc.cursor) < blockSize)
+  {
+    sc.cursor = static_cast<char*>(::operator new(ChunkSize));
+    sc.end    = sc.cursor + ChunkSize;
+  }
+
+  void *block = sc.cursor;
+  sc.cursor += blockSize;
+
+  return block;
+}
+
+
+void
+BlockPool::
+deallocate(void *block, std::size_t size)
+{
+  if (!block)
+    return;
+
+  if (size == 0)
+    size = 1;
+
+  if (size > MaxBlockSize)
+  {
+    ::operator delete(block);
+    return;
+  }
+
+  SizeClass &sc = sizeClass((size - 1) / Granularity);
+
+  std::lock_guard<std::mutex> lock(sc.mutex);
+
+  FreeBlock *freeBlock = static_cast<FreeBlock*>(block);
+  freeBlock->next = sc.freeList;
+  sc.freeList = freeBlock;
+}
@@ -158,6 +158,14 @@ requiredPort() const
 }
 
 
+ConnectionGraphicsObject *
+Connection::
+releaseGraphicsObject()
+{
+  return _connectionGraphicsObject.release();
+}
+
+
 void
 Connection::
 setGraphicsObject(std::unique_ptr<ConnectionGraphicsObject>&& graphics)
@@ -218,6 +226,17 @@ getPortIndex(PortType portType) const
   return result;
 }
 
+
+void
+Connection::
+setPortIndex(PortType portType, PortIndex portIndex)
+{
+  if (portType == PortType::In)
+    _inPortIndex = portIndex;
+  else if (portType == PortType::Out)
+    _outPortIndex = portIndex;
+}
+
 PortIndex
 Connection::
 getGroupPortIndex(PortType portType) const
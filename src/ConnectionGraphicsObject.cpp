@@ -103,9 +103,14 @@ void
 ConnectionGraphicsObject::
 move()
 {
+  // The bounding rect depends on the end points
+  setGeometryChanged();
+
+  // Both ends share the inverted transform and a single repaint
+  QTransform const sceneToLocal = sceneTransform().inverted();
 
   auto moveEndPoint =
-  [this] (PortType portType)
+  [this, &sceneToLocal] (PortType portType)
   {
     if (auto node = _connection.getNode(portType))
     {
@@ -118,22 +123,13 @@ move()
                                    portType,
                                    nodeGraphics.sceneTransform());
 
-      {
-        QTransform sceneTransform = this->sceneTransform();
-
-        QPointF connectionPos = sceneTransform.inverted().map(scenePos);
-
-        _connection.connectionGeometry().setEndPoint(portType,
-                                                     connectionPos);
-
-        _connection.getConnectionGraphicsObject().setGeometryChanged();
-        _connection.getConnectionGraphicsObject().update();
-      }
+      _connection.connectionGeometry().setEndPoint(portType,
+                                                   sceneToLocal.map(scenePos));
     }
   };
 
   auto MoveEndPointGroup =
-  [this] (PortType portType)
+  [this, &sceneToLocal] (PortType portType)
   {
     if (auto group = _connection.getGroup(portType))
     {
@@ -142,18 +138,9 @@ move()
       QPointF scenePos = groupGraphics.portScenePosition(_connection.getGroupPortIndex(portType),
                                    portType);
 
-      {
-        //localToScene transform
-        QTransform sceneTransform = this->sceneTransform();
-
-        //Map from scene position to local position
-        QPointF connectionPos = sceneTransform.inverted().map(scenePos);
-        _connection.connectionGeometry().setEndPoint(portType,
-                                                     connectionPos);
-
-        _connection.getConnectionGraphicsObject().setGeometryChanged();
-        _connection.getConnectionGraphicsObject().update();
-      }
+      //Map from scene position to local position
+      _connection.connectionGeometry().setEndPoint(portType,
+                                                   sceneToLocal.map(scenePos));
     }
   };
 
@@ -175,6 +162,7 @@ move()
     moveEndPoint(PortType::Out);
   }
 
+  update();
 }
 
 void ConnectionGraphicsObject::lock(bool locked)
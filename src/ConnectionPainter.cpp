@@ -81,7 +81,7 @@ paint(QPainter* painter,
   if (connectionStyle.useDataDefinedColors())
   {
 
-    normalColor   = connectionStyle.normalColor(dataType.id);
+    normalColor   = connectionStyle.normalColor(dataType);
     hoverColor    = normalColor.lighter(200);
     selectedColor = normalColor.darker(200);
   }
@@ -1,6 +1,7 @@
 #include "ConnectionStyle.hpp"
 
 #include <iostream>
+#include <vector>
 
 #include <QtCore/QFile>
 #include <QtCore/QJsonDocument>
@@ -11,8 +12,11 @@
 #include <QDebug>
 
 #include "StyleCollection.hpp"
+#include "NodeData.hpp"
 
 using QtNodes::ConnectionStyle;
+using QtNodes::NodeDataType;
+using QtNodes::TypeHandle;
 
 inline void initResources() { Q_INIT_RESOURCE(resources); }
 
@@ -177,6 +181,25 @@ normalColor(QString typeId) const
 }
 
 
+QColor
+ConnectionStyle::
+normalColor(NodeDataType const &dataType) const
+{
+  // Painting only happens in the GUI thread, indexed by type handle
+  static std::vector<QColor> colors;
+
+  TypeHandle const handle = dataType.handle();
+
+  if (handle >= colors.size())
+    colors.resize(handle + 1);
+
+  if (!colors[handle].isValid())
+    colors[handle] = normalColor(dataType.id());
+
+  return colors[handle];
+}
+
+
 QColor
 ConnectionStyle::
 selectedColor() const
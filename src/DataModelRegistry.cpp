@@ -1,10 +1,17 @@
 #include "DataModelRegistry.hpp"
 
 #include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
 #include <QtWidgets/QMessageBox>
 
+#include "SceneFragment.hpp"
+
 using QtNodes::DataModelRegistry;
 using QtNodes::NodeDataModel;
+using QtNodes::SceneFragment;
+using QtNodes::ModelPalette;
+using QtNodes::NodeDataType;
+using QtNodes::TypeRegistry;
 
 std::unique_ptr<NodeDataModel>
 DataModelRegistry::
@@ -36,6 +43,33 @@ DataModelRegistry::RegisteredTemplates()
 }
 
 
+std::shared_ptr<SceneFragment const>
+DataModelRegistry::
+templateDefinition(QString const &templateName)
+{
+  auto path = _registeredTemplates.find(templateName);
+  if (path == _registeredTemplates.end())
+    return nullptr;
+
+  // RegisteredTemplates() hands out the map, the path may have been edited
+  auto it = _templateDefinitions.find(templateName);
+  if (it != _templateDefinitions.end() && it->second.filePath == path->second)
+    return it->second.fragment;
+
+  QFile file(path->second);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    return nullptr;
+
+  QJsonObject const json = QJsonDocument::fromJson(file.readAll()).object();
+
+  std::shared_ptr<SceneFragment const> fragment = SceneFragment::fromJson(json, *this);
+
+  _templateDefinitions[templateName] = TemplateDefinition{ path->second, fragment };
+
+  return fragment;
+}
+
+
 
 DataModelRegistry::RegisteredModelsCategoryMap const &
 DataModelRegistry::
@@ -53,11 +87,35 @@ categories() const
 }
 
 
+ModelPalette const &
+DataModelRegistry::
+palette() const
+{
+  return _palette;
+}
+
+
 std::unique_ptr<NodeDataModel>
 DataModelRegistry::
 getTypeConverter(QString const &sourceTypeID, QString const &destTypeID) const
 {
-  auto typeConverterKey = std::make_pair(sourceTypeID, destTypeID);
+  auto typeConverterKey = converterKey(TypeRegistry::intern(sourceTypeID),
+                                       TypeRegistry::intern(destTypeID));
+  auto converter = _registeredTypeConverters.find(typeConverterKey);
+
+  if (converter != _registeredTypeConverters.end())
+  {
+    return converter->second->Model->clone();
+  }
+  return nullptr;
+}
+
+
+std::unique_ptr<NodeDataModel>
+DataModelRegistry::
+getTypeConverter(NodeDataType const &sourceType, NodeDataType const &destType) const
+{
+  auto typeConverterKey = converterKey(sourceType.handle(), destType.handle());
   auto converter = _registeredTypeConverters.find(typeConverterKey);
 
   if (converter != _registeredTypeConverters.end())
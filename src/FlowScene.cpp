@@ -1,6 +1,8 @@
 #include "FlowScene.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 #include <set>
 #include <tuple>
@@ -29,6 +31,7 @@
 
 #include "FlowView.hpp"
 #include "DataModelRegistry.hpp"
+#include "SceneFragment.hpp"
 
 using QtNodes::FlowScene;
 using QtNodes::Node;
@@ -37,63 +40,155 @@ using QtNodes::NodeGraphicsObject;
 using QtNodes::Connection;
 using QtNodes::DataModelRegistry;
 using QtNodes::NodeDataModel;
+using QtNodes::NodeData;
+using QtNodes::SceneFragment;
+using QtNodes::UndoCommand;
+using QtNodes::ActionCommand;
+using QtNodes::MoveCommand;
+using QtNodes::SceneDiffCommand;
+using QtNodes::FragmentCommand;
 //using QtNodes::Properties;
 using QtNodes::PortType;
 using QtNodes::PortIndex;
+using QtNodes::PoolAllocator;
+
+namespace
+{
+
+// Sorts graphics items by the scene element they show, keeping their order
+void
+splitItems(QList<QGraphicsItem*> const &items,
+           std::vector<Node*> &nodes,
+           std::vector<Connection*> &connections,
+           std::vector<Group*> &groups)
+{
+  for (QGraphicsItem *item : items)
+  {
+    if (auto n = qgraphicsitem_cast<NodeGraphicsObject*>(item))
+      nodes.push_back(&n->node());
+    else if (auto c = qgraphicsitem_cast<QtNodes::ConnectionGraphicsObject*>(item))
+      connections.push_back(&c->connection());
+    else if (auto g = qgraphicsitem_cast<QtNodes::GroupGraphicsObject*>(item))
+      groups.push_back(&g->group());
+  }
+}
+
+
+// `sources` and every node downstream of them, each after those of its
+// sources found among them, the ones on a cycle come last
+std::vector<Node*>
+dependencyOrder(std::vector<Node*> const &sources)
+{
+  std::unordered_map<Node const*, std::size_t> pendingInputs;
+
+  // Downstream closure, breadth first
+  std::vector<Node*> closure;
+  closure.reserve(sources.size());
+
+  for (Node *node : sources)
+  {
+    if (pendingInputs.emplace(node, 0).second)
+      closure.push_back(node);
+  }
+
+  for (std::size_t i = 0; i < closure.size(); ++i)
+  {
+    for (auto const &connections : closure[i]->nodeState().getEntries(PortType::Out))
+    {
+      for (auto const &connection : connections)
+      {
+        Node *successor = connection.second->getNode(PortType::In);
+        if (!successor)
+          continue;
+
+        // Every successor is in the closure, inputs from outside are not counted
+        auto inserted = pendingInputs.emplace(successor, 0);
+        if (inserted.second)
+          closure.push_back(successor);
+
+        ++inserted.first->second;
+      }
+    }
+  }
+
+  std::vector<Node*> order;
+  order.reserve(closure.size());
+
+  for (Node *node : closure)
+  {
+    if (pendingInputs[node] == 0)
+      order.push_back(node);
+  }
+
+  // Kahn's algorithm, the order vector doubles as the queue
+  for (std::size_t i = 0; i < order.size(); ++i)
+  {
+    for (auto const &connections : order[i]->nodeState().getEntries(PortType::Out))
+    {
+      for (auto const &connection : connections)
+      {
+        Node *successor = connection.second->getNode(PortType::In);
+        if (successor && --pendingInputs[successor] == 0)
+          order.push_back(successor);
+      }
+    }
+  }
+
+  if (order.size() < closure.size())
+  {
+    for (Node *node : closure)
+    {
+      if (pendingInputs[node] > 0)
+        order.push_back(node);
+    }
+  }
+
+  return order;
+}
+
+}
 
 
 
 FlowScene::
 FlowScene(std::shared_ptr<DataModelRegistry> registry)
   : _registry(registry)
+  , writeToHistory(true)
+  , _historyMemory(0)
+  , _historyMemoryLimit(64 * 1024 * 1024)
+  , _propagationSuspended(0)
+  , _deliveringNode(nullptr)
+  , _selectionValid(false)
 {
   setItemIndexMethod(QGraphicsScene::NoIndex);
+
+  _connectionUpdateTimer.setSingleShot(true);
+  _connectionUpdateTimer.setInterval(0);
+  connect(&_connectionUpdateTimer, &QTimer::timeout,
+          this, &FlowScene::flushConnectionUpdates);
+
+  // Resizing the scene rect updates the scroll bars of every view,
+  // a few times per second is enough while dragging
+  _sceneRectTimer.setSingleShot(true);
+  _sceneRectTimer.setInterval(50);
+  connect(&_sceneRectTimer, &QTimer::timeout,
+          this, &FlowScene::flushSceneRect);
+
+  connect(this, &QGraphicsScene::selectionChanged,
+          this, &FlowScene::invalidateSelection);
   
   ResetHistory();
   
-  auto UpdateLamda = [this](Node& n, const QPointF& newPosition, const QPointF &oldPosition)
+  // The history entry of a drag is recorded by endMoveGesture
+  auto UpdateLamda = [this](Node& n, const QPointF&, const QPointF&)
   {
     resolveGroups(n);
-    QUuid id = n.id();
-    AddAction(
-      UndoRedoAction(
-        [this, id, oldPosition](void *)
-        {
-          UniqueNode n = _nodes[id];
-          n->nodeGraphicsObject().setPos(oldPosition);
-          return 0;
-        },
-        [this, id, newPosition](void *)
-        {
-
-          UniqueNode n = _nodes[id];
-          n->nodeGraphicsObject().setPos(newPosition);
-          return 0;
-        },
-        "Moved Node " + n.nodeDataModel()->name()
-      )
-    );
   };
   connect(this, &FlowScene::nodeMoveFinished, this, UpdateLamda);
   
-  auto GroupUpdateLamda = [this](Group& g, const QPointF& newPosition, const QPointF& oldPosition)
+  auto GroupUpdateLamda = [this](Group& g, const QPointF&, const QPointF&)
   {
     resolveGroups(g);
-    
-    
-    AddAction(UndoRedoAction(
-      [&g, oldPosition](void *ptr)
-      {
-        g.groupGraphicsObject().setPos(oldPosition);
-        return 0;
-      },
-      [&g, newPosition](void *ptr)
-      {
-        g.groupGraphicsObject().setPos(newPosition);
-        return 0;
-      },
-      "Moved Group " + g.GetName()
-    ));
   };
   connect(this, &FlowScene::groupMoveFinished, this, GroupUpdateLamda);
 
@@ -105,6 +200,10 @@ FlowScene::
 ~FlowScene()
 {
   clearScene();
+
+  // QGraphicsScene still deselects its remaining items on destruction
+  disconnect(this, &QGraphicsScene::selectionChanged,
+             this, &FlowScene::invalidateSelection);
 }
 
 
@@ -116,7 +215,8 @@ createConnection(PortType connectedPort,
                  Node& node,
                  PortIndex portIndex)
 {
-  auto connection = std::make_shared<Connection>(connectedPort, node, portIndex);
+  auto connection = std::allocate_shared<Connection>(PoolAllocator<Connection>(),
+                                                    connectedPort, node, portIndex);
 
   auto cgo = std::make_unique<ConnectionGraphicsObject>(*this, *connection);
 
@@ -140,11 +240,12 @@ createConnection(Node& nodeIn,
 {
 
   auto connection =
-    std::make_shared<Connection>(nodeIn,
-                                 portIndexIn,
-                                 nodeOut,
-                                 portIndexOut, 
-                                 id);
+    std::allocate_shared<Connection>(PoolAllocator<Connection>(),
+                                     nodeIn,
+                                     portIndexIn,
+                                     nodeOut,
+                                     portIndexOut,
+                                     id);
 
   auto cgo = std::make_unique<ConnectionGraphicsObject>(*this, *connection);
 
@@ -160,6 +261,8 @@ createConnection(Node& nodeIn,
 
   _connections[connection->id()] = connection;
 
+  trackConnection(*connection);
+
   connectionCreated(*connection);
   
   return connection;
@@ -216,6 +319,8 @@ FlowScene::
 deleteConnection(Connection& connection)
 {
   connectionDeleted(connection);
+  invalidateSelection();
+  untrackConnection(connection);
   connection.removeFromNodes();
   _connections.erase(connection.id());
 }
@@ -225,6 +330,8 @@ FlowScene::
 deleteConnection(Connection* connection)
 {
   // connectionDeleted(connection);
+  invalidateSelection();
+  untrackConnection(*connection);
   connection->removeFromNodes();
   _connections.erase(connection->id());
 }
@@ -279,11 +386,11 @@ createNodeWithID(std::unique_ptr<NodeDataModel> && dataModel, QUuid id)
 
 Group& FlowScene::createGroup() {
   auto group = std::make_shared<Group>(*this);
-  auto ggo  = std::make_shared<GroupGraphicsObject>(*this, *group);
+  auto ggo  = std::make_unique<GroupGraphicsObject>(*this, *group);
 
   QUuid id = group->id();
   auto groupPtr = group.get();
-  group->setGraphicsObject(ggo);
+  group->setGraphicsObject(std::move(ggo));
   _groups[id] = group;
 
   return *groupPtr;
@@ -294,14 +401,22 @@ Group& FlowScene::createGroup() {
 
 Group&
 FlowScene::
-restoreGroup(QJsonObject const& nodeJson) {
+restoreGroup(QJsonObject const& nodeJson, bool keepId) {
   auto group = std::make_shared<Group>(*this);
-  auto ggo  = std::make_shared<GroupGraphicsObject>(*this, *group);
+  if (keepId)
+  {
+    // A group still in the scene keeps its id, the copy gets a new one
+    QUuid const id(nodeJson["id"].toString());
+    if (!id.isNull() && !_groups.count(id))
+      group->setId(id);
+  }
+
+  auto ggo  = std::make_unique<GroupGraphicsObject>(*this, *group);
 
   QUuid id = group->id();
   auto groupPtr = group.get();
   
-  group->setGraphicsObject(ggo);
+  group->setGraphicsObject(std::move(ggo));
   _groups[id] = group;
   
   
@@ -315,12 +430,12 @@ Group&
 FlowScene::
 pasteGroup(QJsonObject const& groupJson, QPointF nodeGroupCentroid, QPointF mousePos) {
   auto group = std::make_shared<Group>(*this);
-  auto ggo  = std::make_shared<GroupGraphicsObject>(*this, *group);
+  auto ggo  = std::make_unique<GroupGraphicsObject>(*this, *group);
 
   QUuid id = group->id();
   auto groupPtr = group.get();
   
-  group->setGraphicsObject(ggo);
+  group->setGraphicsObject(std::move(ggo));
   _groups[id] = group;
   
   QJsonObject positionJson = groupJson["position"].toObject();
@@ -357,7 +472,8 @@ restoreNode(QJsonObject const& nodeJson, bool keepId)
 	  dataModel = registry().create("DeletedNode");
   }
 
-  auto node = std::make_shared<Node>(std::move(dataModel));
+  // make_shared would bypass Node::operator new, loads come through here
+  auto node = std::allocate_shared<Node>(PoolAllocator<Node>(), std::move(dataModel));
   if(keepId) node->setId(QUuid( nodeJson["id"].toString() ));
   auto ngo  = std::make_unique<NodeGraphicsObject>(*this, *node);
   node->setGraphicsObject(std::move(ngo));
@@ -409,24 +525,29 @@ removeNode(Node& node)
 {
   // call signal
   nodeDeleted(node);
+  invalidateSelection();
 
-  auto deleteConnections =
-    [&node, this] (PortType portType)
+  // Ids are collected first, deleting a connection edits the node state
+  std::vector<QUuid> connectionIds;
+
+  for (PortType portType : { PortType::In, PortType::Out })
+  {
+    for (auto const &connections : node.nodeState().getEntries(portType))
     {
-      auto nodeState = node.nodeState();
-      auto const & nodeEntries = nodeState.getEntries(portType);
+      for (auto const &pair : connections)
+        connectionIds.push_back(pair.first);
+    }
+  }
 
-      for (auto &connections : nodeEntries)
-      {
-        for (auto const &pair : connections)
-          deleteConnection(*pair.second);
-      }
-    };
+  for (QUuid const &connectionId : connectionIds)
+  {
+    auto it = _connections.find(connectionId);
+    if (it != _connections.end())
+      deleteConnection(*it->second);
+  }
 
-  deleteConnections(PortType::In);
-  deleteConnections(PortType::Out);
+  setNodeGroup(node, nullptr);
 
-  
   _nodes.erase(node.id());
 }
 
@@ -436,29 +557,13 @@ void
 FlowScene::
 removeNodeWithID(QUuid id)
 {
-  UniqueNode nodePtr = _nodes[id];
-  Node &node = *nodePtr;
-  // call signal
-  nodeDeleted(node);
-
-  auto deleteConnections =
-    [&node, this] (PortType portType)
-    {
-      auto nodeState = node.nodeState();
-      auto const & nodeEntries = nodeState.getEntries(portType);
-
-      for (auto &connections : nodeEntries)
-      {
-        for (auto const &pair : connections)
-          deleteConnection(*pair.second);
-      }
-    };
-
-  deleteConnections(PortType::In);
-  deleteConnections(PortType::Out);
+  auto it = _nodes.find(id);
+  if (it == _nodes.end())
+    return;
 
-  
-  _nodes.erase(node.id());
+  // Keeps the node alive until removeNode returns
+  UniqueNode nodePtr = it->second;
+  removeNode(*nodePtr);
 }
 
 
@@ -472,14 +577,20 @@ removeGroup(Group& group)
 	{
 		QGraphicsItem *child  = ggo.childItems()[i];
 		NodeGraphicsObject* n = qgraphicsitem_cast<NodeGraphicsObject*>(child);
-		if(n != nullptr)
+		GroupGraphicsObject* g = qgraphicsitem_cast<GroupGraphicsObject*>(child);
+		if(n != nullptr || g != nullptr)
 		{
-			QPointF position = n->scenePos();
-			ggo.childItems()[i]->setParentItem(0);
-			n->setPos(position);
-			n->moveConnections();
+			// Nested items move to the top level instead of being deleted with the group
+			QPointF position = child->scenePos();
+			child->setParentItem(0);
+			child->setPos(position);
+			syncItemGroup(child);
+			if(n != nullptr)
+				n->moveConnections();
 		}
 	}
+	setParentGroup(group, nullptr);
+	invalidateSelection();
 	_groups.erase(group.id());
 }
 
@@ -644,6 +755,7 @@ resolveGroups(Group& group) {
       node->setParentItem(nullptr);
       ggo.childItems().removeAt(i);
       node->setPos(scenePos);
+      syncItemGroup(node);
     }
   }
 
@@ -663,6 +775,7 @@ resolveGroups(Group& group) {
         if(!other->isAncestorOf(&ggo)) {
           other->setParentItem(&ggo);
           other->setPos(parentPos);
+          syncItemGroup(other);
         }
       } else if(otherRect.contains(groupRect)) { // Checks inside of what it is
         QPointF scenePos = ggo.scenePos();
@@ -670,6 +783,7 @@ resolveGroups(Group& group) {
         if(!ggo.isAncestorOf(other)) {
           ggo.setParentItem(other);
           ggo.setPos(parentPos);
+          syncItemGroup(&ggo);
         }
       }
     } else {
@@ -702,6 +816,7 @@ resolveGroups(Node& n) {
         QPointF parentPos = ggo->mapFromScene(scenePos);
         c.setParentItem(ggo);
         c.setPos(parentPos);
+        syncItemGroup(&c);
       }
     }
   }
@@ -711,240 +826,522 @@ resolveGroups(Node& n) {
     QPointF newPos = c.parentItem()->mapToScene(c.pos());
     c.setParentItem(nullptr);
     c.setPos(newPos);
+    syncItemGroup(&c);
   }
 }
 
 
-std::unordered_map<QUuid, std::shared_ptr<Node> > const &
+Group*
 FlowScene::
-nodes() const
+nodeGroup(Node const& node) const
 {
-  return _nodes;
-}
+  auto it = _nodeGroups.find(node.id());
 
-std::unordered_map<QUuid, std::shared_ptr<Node> > &
-FlowScene::
-nodes()
-{
-  return _nodes;
+  return (it != _nodeGroups.end()) ? it->second : nullptr;
 }
 
 
-std::unordered_map<QUuid, std::shared_ptr<Connection> > const &
+Group*
 FlowScene::
-connections() const
+parentGroup(Group const& group) const
 {
-  return _connections;
+  auto it = _groupParents.find(group.id());
+
+  return (it != _groupParents.end()) ? it->second : nullptr;
 }
 
 
-std::vector<Node*>
+void
 FlowScene::
-selectedNodes() const
+trackConnection(Connection& connection)
 {
-  QList<QGraphicsItem*> graphicsItems = selectedItems();
+  Node *nodeOut = connection.getNode(PortType::Out);
+  Node *nodeIn  = connection.getNode(PortType::In);
 
-  std::vector<Node*> ret;
-  ret.reserve(graphicsItems.size());
-  
+  if (!nodeOut || !nodeIn)
+    return;
 
-  for (QGraphicsItem* item : graphicsItems)
-  {
-    auto ngo = qgraphicsitem_cast<NodeGraphicsObject*>(item);
+  Group *groupOut = nodeGroup(*nodeOut);
+  Group *groupIn  = nodeGroup(*nodeIn);
 
-    if (ngo != nullptr)
-    {
-      Node* n = &(ngo->node());
-      ret.push_back(n);
-    }
+  if (groupOut && groupOut == groupIn)
+  {
+    groupOut->addConnection(&connection, PortType::None);
+    return;
   }
 
-  return ret;
-}
+  if (groupIn)
+    groupIn->addConnection(&connection, PortType::In);
 
+  if (groupOut)
+    groupOut->addConnection(&connection, PortType::Out);
+}
 
-//------------------------------------------------------------------------------
 
 void
 FlowScene::
-clearScene()
+untrackConnection(Connection& connection)
 {
-  //Manual node cleanup. Simply clearing the holding datastructures doesn't work, the code crashes when
-  // there are both nodes and connections in the scene. (The data propagation internal logic tries to propagate
-  // data through already freed connections.)
-  std::vector<Node*> nodesToDelete;
-  for (auto& node : _nodes)
-  {
-    nodesToDelete.push_back(node.second.get());
-  }
+  Node *nodeOut = connection.getNode(PortType::Out);
+  Node *nodeIn  = connection.getNode(PortType::In);
+
+  if (!nodeOut || !nodeIn)
+    return;
+
+  Group *groupOut = nodeGroup(*nodeOut);
+  Group *groupIn  = nodeGroup(*nodeIn);
 
-  for (auto& node : nodesToDelete)
+  if (groupOut && groupOut == groupIn)
   {
-    removeNode(*node);
+    groupOut->removeConnection(&connection, PortType::None);
+    return;
   }
 
-  _groups.clear();
-  // for (auto& group : _groups)
-  // {
-  //   _groups.erase(group.first);
-  // }
+  if (groupIn)
+    groupIn->removeConnection(&connection, PortType::In);
+
+  if (groupOut)
+    groupOut->removeConnection(&connection, PortType::Out);
 }
 
 
 void
 FlowScene::
-save() const
+syncItemGroup(QGraphicsItem *item)
 {
-  QString fileName =
-    QFileDialog::getSaveFileName(nullptr,
-                                 tr("Open Flow Scene"),
-                                 QDir::homePath(),
-                                 tr("Flow Scene Files (*.flow)"));
-
-  if (!fileName.isEmpty())
-  {
-    if (!fileName.endsWith("flow", Qt::CaseInsensitive))
-      fileName += ".flow";
+  auto parent = qgraphicsitem_cast<GroupGraphicsObject*>(item->parentItem());
+  Group *group = parent ? &parent->group() : nullptr;
 
-    QFile file(fileName);
-    if (file.open(QIODevice::WriteOnly))
-    {
-      file.write(saveToMemory());
-    }
-  }
+  if (auto ngo = qgraphicsitem_cast<NodeGraphicsObject*>(item))
+    setNodeGroup(ngo->node(), group);
+  else if (auto ggo = qgraphicsitem_cast<GroupGraphicsObject*>(item))
+    setParentGroup(ggo->group(), group);
 }
 
 
 void
 FlowScene::
-load()
+setNodeGroup(Node& node, Group* group)
 {
-  clearScene();
-
-  //-------------
+  Group *current = nodeGroup(node);
 
-  QString fileName =
-    QFileDialog::getOpenFileName(nullptr,
-                                 tr("Open Flow Scene"),
-                                 QDir::homePath(),
-                                 tr("Flow Scene Files (*.flow)"));
-
-  if (!QFileInfo::exists(fileName))
+  if (current == group)
     return;
 
-  QFile file(fileName);
+  // The connections are filed by the groups of their ends
+  std::vector<Connection*> const connections = node.nodeState().allConnections();
 
-  if (!file.open(QIODevice::ReadOnly))
-    return;
+  for (Connection *connection : connections)
+    untrackConnection(*connection);
 
-  QByteArray wholeFile = file.readAll();
+  if (current)
+    current->removeNode(&node);
 
-  loadFromMemory(wholeFile);
+  if (group)
+  {
+    group->addNode(&node);
+    _nodeGroups[node.id()] = group;
+  }
+  else
+  {
+    _nodeGroups.erase(node.id());
+  }
+
+  for (Connection *connection : connections)
+    trackConnection(*connection);
 }
 
 
-QByteArray
+void
 FlowScene::
-saveToMemory() const
+setParentGroup(Group& group, Group* parent)
 {
-  QJsonObject sceneJson;
+  Group *current = parentGroup(group);
 
-  QJsonArray groupsJsonArray;
-  for (auto const & pair : _groups)
+  if (current == parent)
+    return;
+
+  if (current)
+    current->removeChildGroup(&group);
+
+  if (parent)
   {
-    auto const &group = pair.second;
-    groupsJsonArray.append(group->save());
+    parent->addChildGroup(&group);
+    _groupParents[group.id()] = parent;
   }
-  sceneJson["groups"] = groupsJsonArray;
-
-  QJsonArray nodesJsonArray;
-  for (auto const & pair : _nodes)
+  else
   {
-    auto const &node = pair.second;
-
-    nodesJsonArray.append(node->save());
+    _groupParents.erase(group.id());
   }
-  sceneJson["nodes"] = nodesJsonArray;
+}
 
-  QJsonArray connectionJsonArray;
-  std::set<std::tuple<QUuid, PortIndex, QUuid, PortIndex>> uniqueConnections;
-  
-  for (auto const & pair : _connections)
+
+void
+FlowScene::
+scheduleConnectionUpdate(Node const& node)
+{
+  _connectionUpdateNodes.insert(node.id());
+
+  if (!_connectionUpdateTimer.isActive())
+    _connectionUpdateTimer.start();
+}
+
+
+void
+FlowScene::
+flushConnectionUpdates()
+{
+  _connectionUpdateTimer.stop();
+
+  // A connection between two moved nodes is collected twice but moved once
+  std::unordered_set<ConnectionGraphicsObject*> dirty;
+
+  for (QUuid const &id : _connectionUpdateNodes)
   {
-    auto const &connection = pair.second;
+    auto it = _nodes.find(id);
+    if (it == _nodes.end())
+      continue;
 
-    QJsonObject connectionJson = connection->save();
+    NodeState const &state = it->second->nodeState();
 
-    if (!connectionJson.isEmpty())
+    for (PortType portType : { PortType::In, PortType::Out })
     {
-      // Extract connection details for duplicate detection
-      QUuid nodeInId = QUuid(connectionJson["in_id"].toString());
-      QUuid nodeOutId = QUuid(connectionJson["out_id"].toString());
-      PortIndex portIndexIn = connectionJson["in_index"].toInt();
-      PortIndex portIndexOut = connectionJson["out_index"].toInt();
-      
-      // Create a unique identifier tuple
-      auto connectionKey = std::make_tuple(nodeInId, portIndexIn, nodeOutId, portIndexOut);
-      
-      // Only add if we haven't seen this connection before
-      if (uniqueConnections.find(connectionKey) == uniqueConnections.end())
+      for (auto const &connections : state.getEntries(portType))
       {
-        uniqueConnections.insert(connectionKey);
-        connectionJsonArray.append(connectionJson);
+        for (auto const &pair : connections)
+          dirty.insert(&pair.second->getConnectionGraphicsObject());
       }
     }
   }
 
-  sceneJson["connections"] = connectionJsonArray;
-
-  QJsonArray anchorsJsonArray;
-  for(int i=0; i<anchors.size(); i++) {
-    QJsonObject anchor;
-    anchor["position_x"] = anchors[i].position.x();
-    anchor["position_y"] = anchors[i].position.y();
-    anchor["scale"] = anchors[i].scale;
-    anchorsJsonArray.append(anchor);
-  }
-
-  sceneJson["anchors"] = anchorsJsonArray;
-
-  QJsonDocument document(sceneJson);
+  _connectionUpdateNodes.clear();
 
-  return document.toJson();
+  for (ConnectionGraphicsObject *cgo : dirty)
+    cgo->move();
 }
 
 
-void FlowScene::saveToClipBoard()
+void
+FlowScene::
+expandSceneRect(QRectF const& rect)
 {
+  if (_contentBounds.contains(rect))
+    return;
 
+  _contentBounds = _contentBounds.united(rect);
+
+  if (!_sceneRectTimer.isActive())
+    _sceneRectTimer.start();
 }
 
+
 void
 FlowScene::
-loadFromMemory(const QByteArray& data)
+flushSceneRect()
 {
-  QJsonObject const jsonDocument = QJsonDocument::fromJson(data).object();
+  _sceneRectTimer.stop();
 
-  QJsonArray nodesJsonArray = jsonDocument["nodes"].toArray();
+  if (_contentBounds.isNull())
+    return;
 
-  for (int i = 0; i < nodesJsonArray.size(); ++i)
-  {
-    restoreNode(nodesJsonArray[i].toObject());
-  }
+  QRectF const current = sceneRect();
 
-  QJsonArray connectionJsonArray = jsonDocument["connections"].toArray();
+  if (!current.contains(_contentBounds))
+    setSceneRect(current.united(_contentBounds));
+}
 
-  for (int i = 0; i < connectionJsonArray.size(); ++i)
-  {
-    QJsonObject jsonObject = connectionJsonArray[i].toObject();
-    QUuid nodeInId = QUuid(jsonObject["in_id"].toString());
-    auto nodeIn = _nodes[nodeInId].get();    
-    nodeIn->targetInputConnections++;
-  }
 
-  std::stable_sort( connectionJsonArray.begin( ), connectionJsonArray.end( ), [this]( const auto& lhs, const auto& rhs )
-  {
-    QPointF posA, posB;
+std::unordered_map<QUuid, std::shared_ptr<Node> > const &
+FlowScene::
+nodes() const
+{
+  return _nodes;
+}
+
+std::unordered_map<QUuid, std::shared_ptr<Node> > &
+FlowScene::
+nodes()
+{
+  return _nodes;
+}
+
+
+std::unordered_map<QUuid, std::shared_ptr<Group> > const &
+FlowScene::
+groups() const
+{
+  return _groups;
+}
+
+
+std::unordered_map<QUuid, std::shared_ptr<Connection> > const &
+FlowScene::
+connections() const
+{
+  return _connections;
+}
+
+
+std::vector<Node*> const &
+FlowScene::
+selectedNodes() const
+{
+  updateSelection();
+
+  return _selectedNodes;
+}
+
+
+std::vector<Connection*> const &
+FlowScene::
+selectedConnections() const
+{
+  updateSelection();
+
+  return _selectedConnections;
+}
+
+
+std::vector<Group*> const &
+FlowScene::
+selectedGroups() const
+{
+  updateSelection();
+
+  return _selectedGroups;
+}
+
+
+void
+FlowScene::
+invalidateSelection()
+{
+  _selectionValid = false;
+}
+
+
+void
+FlowScene::
+updateSelection() const
+{
+  if (_selectionValid)
+    return;
+
+  _selectedNodes.clear();
+  _selectedConnections.clear();
+  _selectedGroups.clear();
+
+  splitItems(selectedItems(), _selectedNodes, _selectedConnections, _selectedGroups);
+
+  _selectionValid = true;
+}
+
+
+//------------------------------------------------------------------------------
+
+void
+FlowScene::
+clearScene()
+{
+  // Observers see every item while the scene is still intact
+  for (auto const &pair : _connections)
+    connectionDeleted(*pair.second);
+
+  for (auto const &pair : _nodes)
+    nodeDeleted(*pair.second);
+
+  // Detached connections neither propagate empty data nor repaint their
+  // nodes when destroyed, nothing gets evaluated on the way out
+  for (auto const &pair : _connections)
+  {
+    pair.second->clearNode(PortType::In);
+    pair.second->clearNode(PortType::Out);
+  }
+
+  // Removing the items one by one costs linear time each, the scene drops
+  // all of them at once instead, node items inside groups with their parent
+  clearSelection();
+
+  for (auto const &pair : _connections)
+    pair.second->releaseGraphicsObject();
+
+  for (auto const &pair : _nodes)
+    pair.second->releaseGraphicsObject();
+
+  for (auto const &pair : _groups)
+    pair.second->releaseGraphicsObject();
+
+  QGraphicsScene::clear();
+
+  _connections.clear();
+
+  _pendingPropagation.clear();
+  _connectionUpdateNodes.clear();
+
+  _nodeGroups.clear();
+  _nodes.clear();
+
+  _groupParents.clear();
+  _groups.clear();
+
+  invalidateSelection();
+}
+
+
+void
+FlowScene::
+save() const
+{
+  QString fileName =
+    QFileDialog::getSaveFileName(nullptr,
+                                 tr("Open Flow Scene"),
+                                 QDir::homePath(),
+                                 tr("Flow Scene Files (*.flow)"));
+
+  if (!fileName.isEmpty())
+  {
+    if (!fileName.endsWith("flow", Qt::CaseInsensitive))
+      fileName += ".flow";
+
+    QFile file(fileName);
+    if (file.open(QIODevice::WriteOnly))
+    {
+      file.write(saveToMemory());
+    }
+  }
+}
+
+
+void
+FlowScene::
+load()
+{
+  clearScene();
+
+  //-------------
+
+  QString fileName =
+    QFileDialog::getOpenFileName(nullptr,
+                                 tr("Open Flow Scene"),
+                                 QDir::homePath(),
+                                 tr("Flow Scene Files (*.flow)"));
+
+  if (!QFileInfo::exists(fileName))
+    return;
+
+  QFile file(fileName);
+
+  if (!file.open(QIODevice::ReadOnly))
+    return;
+
+  QByteArray wholeFile = file.readAll();
+
+  loadFromMemory(wholeFile);
+}
+
+
+QByteArray
+FlowScene::
+saveToMemory() const
+{
+  QJsonObject sceneJson;
+
+  QJsonArray groupsJsonArray;
+  for (auto const & pair : _groups)
+  {
+    auto const &group = pair.second;
+    groupsJsonArray.append(group->save());
+  }
+  sceneJson["groups"] = groupsJsonArray;
+
+  QJsonArray nodesJsonArray;
+  for (auto const & pair : _nodes)
+  {
+    auto const &node = pair.second;
+
+    nodesJsonArray.append(node->save());
+  }
+  sceneJson["nodes"] = nodesJsonArray;
+
+  QJsonArray connectionJsonArray;
+  std::set<std::tuple<QUuid, PortIndex, QUuid, PortIndex>> uniqueConnections;
+  
+  for (auto const & pair : _connections)
+  {
+    auto const &connection = pair.second;
+
+    QJsonObject connectionJson = connection->save();
+
+    if (!connectionJson.isEmpty())
+    {
+      // Extract connection details for duplicate detection
+      QUuid nodeInId = QUuid(connectionJson["in_id"].toString());
+      QUuid nodeOutId = QUuid(connectionJson["out_id"].toString());
+      PortIndex portIndexIn = connectionJson["in_index"].toInt();
+      PortIndex portIndexOut = connectionJson["out_index"].toInt();
+      
+      // Create a unique identifier tuple
+      auto connectionKey = std::make_tuple(nodeInId, portIndexIn, nodeOutId, portIndexOut);
+      
+      // Only add if we haven't seen this connection before
+      if (uniqueConnections.find(connectionKey) == uniqueConnections.end())
+      {
+        uniqueConnections.insert(connectionKey);
+        connectionJsonArray.append(connectionJson);
+      }
+    }
+  }
+
+  sceneJson["connections"] = connectionJsonArray;
+
+  QJsonArray anchorsJsonArray;
+  for(int i=0; i<anchors.size(); i++) {
+    QJsonObject anchor;
+    anchor["position_x"] = anchors[i].position.x();
+    anchor["position_y"] = anchors[i].position.y();
+    anchor["scale"] = anchors[i].scale;
+    anchorsJsonArray.append(anchor);
+  }
+
+  sceneJson["anchors"] = anchorsJsonArray;
+
+  QJsonDocument document(sceneJson);
+
+  return document.toJson();
+}
+
+
+void FlowScene::saveToClipBoard()
+{
+
+}
+
+void
+FlowScene::
+loadFromMemory(const QByteArray& data)
+{
+  QJsonObject const jsonDocument = QJsonDocument::fromJson(data).object();
+
+  QJsonArray nodesJsonArray = jsonDocument["nodes"].toArray();
+
+  for (int i = 0; i < nodesJsonArray.size(); ++i)
+  {
+    restoreNode(nodesJsonArray[i].toObject());
+  }
+
+  QJsonArray connectionJsonArray = jsonDocument["connections"].toArray();
+
+  for (int i = 0; i < connectionJsonArray.size(); ++i)
+  {
+    QJsonObject jsonObject = connectionJsonArray[i].toObject();
+    QUuid nodeInId = QUuid(jsonObject["in_id"].toString());
+    auto nodeIn = _nodes[nodeInId].get();    
+    nodeIn->targetInputConnections++;
+  }
+
+  std::stable_sort( connectionJsonArray.begin( ), connectionJsonArray.end( ), [this]( const auto& lhs, const auto& rhs )
+  {
+    QPointF posA, posB;
     QString nameA, nameB;
     {
       QJsonObject objA = lhs.toObject();
@@ -1015,38 +1412,168 @@ loadFromMemory(const QByteArray& data)
 void FlowScene::PrintActions()
 {
   qDebug() << "ACTIONS ";
-  for(int i=0; i<undoActions.size(); i++)
+  for (auto const &command : _undoCommands)
   {
-    qDebug() << undoActions[i].name;
+    qDebug() << command->name();
   }
-  for(int i=0; i<redoActions.size(); i++)
+  for (auto const &command : _redoCommands)
   {
-    qDebug() << " -  " << redoActions[i].name;
+    qDebug() << " -  " << command->name();
   }
 }
 
 void FlowScene::AddAction(QtNodes::UndoRedoAction action)
 {
-  if(writeToHistory)
+  pushCommand(std::make_unique<ActionCommand>(std::move(action)));
+}
+
+void FlowScene::pushCommand(std::unique_ptr<UndoCommand> command)
+{
+  if(!writeToHistory)
+    return;
+
+  for (auto const &redoCommand : _redoCommands)
+    _historyMemory -= redoCommand->memoryUsage();
+  _redoCommands.clear();
+
+  QString const name = command->name();
+
+  if (!_undoCommands.empty())
+  {
+    UndoCommand &last = *_undoCommands.back();
+    std::size_t const lastUsage = last.memoryUsage();
+
+    if (last.mergeWith(*command))
+    {
+      _historyMemory += last.memoryUsage() - lastUsage;
+      emit ActionAdded(name);
+      return;
+    }
+  }
+
+  _historyMemory += command->memoryUsage();
+  _undoCommands.push_back(std::move(command));
+  historyInx++;
+
+  // Forget the oldest steps, the one just recorded always stays
+  while (_historyMemory > _historyMemoryLimit && _undoCommands.size() > 1)
+  {
+    _historyMemory -= _undoCommands.front()->memoryUsage();
+    _undoCommands.pop_front();
+  }
+
+  emit ActionAdded(name);
+}
+
+void FlowScene::beginMoveGesture(QGraphicsItem *grabbed)
+{
+  ++_moveGesture;
+
+  _gestureGroupIds.clear();
+  _gestureNodeIds.clear();
+  _gestureStartPositions.clear();
+
+  std::vector<Node*> nodes = selectedNodes();
+  std::vector<Group*> groups = selectedGroups();
+
+  if (grabbed && !grabbed->isSelected())
   {
-    undoActions.push_back(action);
-    redoActions.clear();
-    historyInx++;
-    emit ActionAdded(action.name);
+    if (auto n = qgraphicsitem_cast<NodeGraphicsObject*>(grabbed))
+      nodes.push_back(&n->node());
+    else if (auto g = qgraphicsitem_cast<GroupGraphicsObject*>(grabbed))
+      groups.push_back(&g->group());
+  }
+
+  auto addPosition = [this](QGraphicsItem const &item)
+    {
+      QPointF const position = item.scenePos();
+      _gestureStartPositions.push_back(position.x());
+      _gestureStartPositions.push_back(position.y());
+    };
+
+  // Groups first, matching the MoveCommand layout
+  for (Group *group : groups)
+  {
+    _gestureGroupIds.push_back(group->id());
+    addPosition(group->groupGraphicsObject());
+  }
+
+  for (Node *node : nodes)
+  {
+    _gestureNodeIds.push_back(node->id());
+    addPosition(node->nodeGraphicsObject());
+  }
+}
+
+void FlowScene::endMoveGesture()
+{
+  std::vector<QUuid> groupIds;
+  std::vector<QUuid> nodeIds;
+  std::vector<qreal> positions;
+
+  // Only the items that actually moved are kept
+  auto addIfMoved = [&positions, this](QGraphicsItem const &item, std::size_t index)
+    {
+      QPointF const start(_gestureStartPositions[2 * index],
+                          _gestureStartPositions[2 * index + 1]);
+      QPointF const end = item.scenePos();
+
+      if (start == end)
+        return false;
+
+      positions.push_back(start.x());
+      positions.push_back(start.y());
+      positions.push_back(end.x());
+      positions.push_back(end.y());
+      return true;
+    };
+
+  for (std::size_t i = 0; i < _gestureGroupIds.size(); ++i)
+  {
+    auto it = _groups.find(_gestureGroupIds[i]);
+    if (it != _groups.end() && addIfMoved(it->second->groupGraphicsObject(), i))
+      groupIds.push_back(_gestureGroupIds[i]);
+  }
+
+  for (std::size_t i = 0; i < _gestureNodeIds.size(); ++i)
+  {
+    auto it = _nodes.find(_gestureNodeIds[i]);
+    if (it != _nodes.end() && addIfMoved(it->second->nodeGraphicsObject(), _gestureGroupIds.size() + i))
+      nodeIds.push_back(_gestureNodeIds[i]);
   }
+
+  _gestureGroupIds.clear();
+  _gestureNodeIds.clear();
+  _gestureStartPositions.clear();
+
+  if (positions.empty())
+    return;
+
+  QString name;
+  if (groupIds.size() + nodeIds.size() > 1)
+    name = QString("Moved %1 Items").arg(static_cast<int>(groupIds.size() + nodeIds.size()));
+  else if (!groupIds.empty())
+    name = "Moved Group " + _groups[groupIds.front()]->GetName();
+  else
+    name = "Moved Node " + _nodes[nodeIds.front()]->nodeDataModel()->name();
+
+  pushCommand(std::make_unique<MoveCommand>(std::move(groupIds),
+                                            std::move(nodeIds),
+                                            std::move(positions),
+                                            name,
+                                            _moveGesture));
 }
 
 void FlowScene::Undo()
 {
-  PrintActions();
-  if(undoActions.size()>0)
+  if(_undoCommands.size()>0)
   {
     writeToHistory = false; 
-    UndoRedoAction action = undoActions[undoActions.size()-1];
-    undoActions.pop_back();
-    action.undoAction(0);
+    std::unique_ptr<UndoCommand> command = std::move(_undoCommands.back());
+    _undoCommands.pop_back();
+    command->undo(*this);
 
-    redoActions.push_back(action);
+    _redoCommands.push_back(std::move(command));
     historyInx--;
     writeToHistory = true; 
   }
@@ -1054,15 +1581,14 @@ void FlowScene::Undo()
   
 void FlowScene::Redo()
 {
-  PrintActions();
-  if(redoActions.size()>0)
+  if(_redoCommands.size()>0)
   {
     writeToHistory = false; 
-    UndoRedoAction action = redoActions[redoActions.size()-1];
-    redoActions.pop_back();
-    action.redoAction(0);
+    std::unique_ptr<UndoCommand> command = std::move(_redoCommands.back());
+    _redoCommands.pop_back();
+    command->redo(*this);
 
-    undoActions.push_back(action);
+    _undoCommands.push_back(std::move(command));
     writeToHistory = true;  
     historyInx++;
   }
@@ -1073,8 +1599,9 @@ void FlowScene::Redo()
 void FlowScene::ResetHistory()
 {
   historyInx=0;
-  undoActions.clear();
-  redoActions.clear();
+  _undoCommands.clear();
+  _redoCommands.clear();
+  _historyMemory = 0;
 }
 
 
@@ -1083,60 +1610,129 @@ int FlowScene::GetHistoryIndex() {
 }
 
 
+std::deque<std::unique_ptr<QtNodes::UndoCommand>> const &
+FlowScene::
+undoCommands() const
+{
+  return _undoCommands;
+}
+
+
+std::deque<std::unique_ptr<QtNodes::UndoCommand>> const &
+FlowScene::
+redoCommands() const
+{
+  return _redoCommands;
+}
+
+
+std::size_t
+FlowScene::
+historyMemoryUsage() const
+{
+  return _historyMemory;
+}
+
+
+std::size_t
+FlowScene::
+historyMemoryLimit() const
+{
+  return _historyMemoryLimit;
+}
+
+
+void
+FlowScene::
+setHistoryMemoryLimit(std::size_t bytes)
+{
+  _historyMemoryLimit = bytes;
+
+  while (_historyMemory > _historyMemoryLimit && !_redoCommands.empty())
+  {
+    _historyMemory -= _redoCommands.front()->memoryUsage();
+    _redoCommands.pop_front();
+  }
+
+  while (_historyMemory > _historyMemoryLimit && _undoCommands.size() > 1)
+  {
+    _historyMemory -= _undoCommands.front()->memoryUsage();
+    _undoCommands.pop_front();
+  }
+}
+
+
 
 void
 FlowScene::
 deleteSelectedNodes()
 {
-	QJsonObject sceneJson = selectionToJson(true);
-  qDebug() << sceneJson;
+  QJsonObject sceneJson = selectionToJson(true);
+
+  // Deleting invalidates the selection, remember ids only
+  std::vector<QUuid> connectionIds;
+  std::vector<QUuid> groupIds;
   std::vector<QUuid> nodeIds;
-  std::vector<QUuid> connectionsIds;
-  for (QGraphicsItem * item : selectedItems())
+
+  for (Connection *connection : selectedConnections())
+    connectionIds.push_back(connection->id());
+
+  for (Group *group : selectedGroups())
+    groupIds.push_back(group->id());
+
+  for (Node *node : selectedNodes())
+    nodeIds.push_back(node->id());
+
+  // Nodes left behind see their inputs cleared once, at the end
+  suspendPropagation();
+
+  for (QUuid const &id : connectionIds)
   {
-    if(item)
-    {
-      if (auto c = qgraphicsitem_cast<ConnectionGraphicsObject*>(item))
-      {
-          deleteConnection(c->connection());      
-      }
-    }
+    auto it = _connections.find(id);
+    if (it != _connections.end())
+      deleteConnection(*it->second);
   }
-  for (QGraphicsItem * item : selectedItems())
+
+  for (QUuid const &id : groupIds)
   {
-    if(item)
-    {
-      if (auto c = qgraphicsitem_cast<GroupGraphicsObject*>(item))
-      {
-        removeGroup(c->group());      
-      }
-      else if (auto c = qgraphicsitem_cast<NodeGraphicsObject*>(item))
-      {
-          removeNode(c->node());
-      }
-    }
+    auto it = _groups.find(id);
+    if (it != _groups.end())
+      removeGroup(*it->second);
   }
-  
-  
-  AddAction(UndoRedoAction(
-    //Undo action
-    [this, sceneJson](void *ptr) 
-    {
-      jsonToScene(sceneJson);
-      return 0;
-    },
-    //Redo action
-    [this, sceneJson](void *ptr)
-    {
-      deleteJsonElements(sceneJson);
-      return 0;
-    },
-    //Name
-    "Deletes nodes"
-  ));
+
+  for (QUuid const &id : nodeIds)
+    removeNodeWithID(id);
+
+  resumePropagation();
+
+  pushCommand(std::make_unique<SceneDiffCommand>(SceneDiffCommand::Kind::Removed,
+                                                 sceneJson,
+                                                 "Deletes nodes"));
 }
 
 QJsonObject FlowScene::selectionToJson(bool includePartialConnections)
+{
+  return selectionToJson(selectedNodes(),
+                         selectedConnections(),
+                         selectedGroups(),
+                         includePartialConnections);
+}
+
+QJsonObject FlowScene::selectionToJson(QList<QGraphicsItem*> const &items, bool includePartialConnections)
+{
+  std::vector<Node*> nodes;
+  std::vector<Connection*> connections;
+  std::vector<Group*> groups;
+
+  splitItems(items, nodes, connections, groups);
+
+  return selectionToJson(nodes, connections, groups, includePartialConnections);
+}
+
+QJsonObject FlowScene::selectionToJson(std::vector<Node*> const &nodes,
+                                       std::vector<Connection*> const &connections,
+                                       std::vector<Group*> const &groups,
+                                       bool includePartialConnections)
 {
   QJsonObject sceneJson;
   QJsonArray nodesJsonArray;
@@ -1144,11 +1740,9 @@ QJsonObject FlowScene::selectionToJson(bool includePartialConnections)
   std::set<QUuid> addedNodeIds;
   std::set<QUuid> addedConnectionIds;
   
-  for (QGraphicsItem * item : selectedItems())
+  for (Node * n : nodes)
 	{
-		if (auto n = qgraphicsitem_cast<NodeGraphicsObject*>(item))
-		{
-        Node& node = n->node();
+        Node& node = *n;
         nodesJsonArray.append(node.save());
         addedNodeIds.insert(node.id());
 
@@ -1168,15 +1762,13 @@ QJsonObject FlowScene::selectionToJson(bool includePartialConnections)
             }
           }
         }
-    }
   }
 
   if(!includePartialConnections)
   {
-    for (QGraphicsItem * item : selectedItems())
+    for (Connection * c : connections)
     {
-      if (auto c = qgraphicsitem_cast<ConnectionGraphicsObject*>(item)) {
-          Connection& connection = c->connection();
+          Connection& connection = *c;
           QUuid inNodeId = connection.getNode(PortType::In)->id();
           QUuid outNodeId = connection.getNode(PortType::Out)->id();
           if(addedNodeIds.find(inNodeId) == addedNodeIds.end()) continue; //The input node is not selected
@@ -1188,29 +1780,21 @@ QJsonObject FlowScene::selectionToJson(bool includePartialConnections)
               connectionJsonArray.append(connectionJson);
               addedConnectionIds.insert(connection.id());
           }
-      }
     }
   }
 
   
   QJsonArray groupJsonArray;
-  for (QGraphicsItem * item : selectedItems())
+  for (Group * g : groups)
 	{
-    if (auto c = qgraphicsitem_cast<GroupGraphicsObject*>(item)) {
-        Group& group = c->group();
-
+        Group& group = *g;
         //If collapsed
         if(group.groupGraphicsObject().isCollapsed())
         {
           //Add all child items to nodes array
-          for(int i=0; i<group.groupGraphicsObject().childItems().size(); i++)
+          for(Node *node : group.nodes())
           {
-            NodeGraphicsObject* ngo = dynamic_cast<NodeGraphicsObject*>(group.groupGraphicsObject().childItems()[i]);
-            if(ngo!=nullptr)
-            {
-              Node& node = ngo->node();
-              nodesJsonArray.append(node.save());
-            }
+            nodesJsonArray.append(node->save());
           }
 
           //Add all connections to nodes array
@@ -1228,7 +1812,6 @@ QJsonObject FlowScene::selectionToJson(bool includePartialConnections)
         QJsonObject groupJson = group.save();
         if (!groupJson.isEmpty())
           groupJsonArray.append(groupJson);
-    }
   }
 
   sceneJson["nodes"] = nodesJsonArray;
@@ -1263,7 +1846,7 @@ void FlowScene::jsonToScene(QJsonObject jsonDocument)
     QJsonArray groupsJsonArray = jsonDocument["groups"].toArray();
     for (int i = 0; i < groupsJsonArray.size(); ++i)
     {
-      restoreGroup(groupsJsonArray[i].toObject());
+      restoreGroup(groupsJsonArray[i].toObject(), true);
     }
 }
 
@@ -1331,32 +1914,176 @@ void FlowScene::jsonToSceneMousePos(QJsonObject jsonDocument, QPointF mousePos)
     QJsonArray groupsJsonArray = jsonDocument["groups"].toArray();
     for (int i = 0; i < groupsJsonArray.size(); ++i)
     {
-      pasteGroup(groupsJsonArray[i].toObject(), centroid, mousePos);
+      Group &group = pasteGroup(groupsJsonArray[i].toObject(), centroid, mousePos);
+      groupsJsonArray[i] = group.save();
     }
-  
+    jsonDocument["groups"] = groupsJsonArray;
 
-    AddAction(UndoRedoAction(
-        [this, addedIds](void *ptr)
-        {
-          //Delete all the created nodes (and their connections)
-          for(auto &id: addedIds)
-          {
-            removeNodeWithID(id.second);
-          }
-          return 0;
-        },
-        [this, jsonDocument](void *ptr)
-        {       
-          jsonToScene(jsonDocument); //jsonDocument has now been updated with new IDs and new positions
-          return 0;
-        },
-        "Created Node "
-      ));
+    //jsonDocument has now been updated with new IDs and new positions
+    pushCommand(std::make_unique<SceneDiffCommand>(SceneDiffCommand::Kind::Added,
+                                                   jsonDocument,
+                                                   "Created Node "));
 
 }
 
+std::shared_ptr<QtNodes::SceneFragment>
+FlowScene::
+copyFragment() const
+{
+  auto fragment = std::make_shared<SceneFragment>();
+
+  // Index of every copied node in the fragment
+  std::unordered_map<Node const*, int> indices;
+
+  auto copyNode = [&fragment, &indices](Node const &node)
+    {
+      if (indices.count(&node))
+        return;
+
+      NodeDataModel const &model = *node.nodeDataModel();
+
+      // clone() gives a fresh instance, the state follows through restore
+      std::unique_ptr<NodeDataModel> copy = model.clone();
+      copy->restore(model.save());
+
+      indices[&node] = static_cast<int>(fragment->models.size());
+      fragment->models.push_back(std::move(copy));
+      fragment->positions.push_back(node.nodeGraphicsObject().scenePos());
+    };
+
+  for (Node *node : selectedNodes())
+    copyNode(*node);
+
+  for (Group *group : selectedGroups())
+  {
+    GroupGraphicsObject &ggo = group->groupGraphicsObject();
+
+    // Collapsed groups carry their nodes, like selectionToJson
+    if (ggo.isCollapsed())
+    {
+      for (Node *node : group->nodes())
+        copyNode(*node);
+    }
+
+    fragment->groups.append(group->save());
+  }
+
+  // Same connections as selectionToJson(false): selected ones
+  // between two copied nodes
+  for (Connection *connection : selectedConnections())
+  {
+    auto out = indices.find(connection->getNode(PortType::Out));
+    auto in  = indices.find(connection->getNode(PortType::In));
+
+    if (out == indices.end() || in == indices.end())
+      continue;
+
+    fragment->connections.push_back({ out->second,
+                                      connection->getPortIndex(PortType::Out),
+                                      in->second,
+                                      connection->getPortIndex(PortType::In) });
+  }
+
+  return fragment;
+}
+
+
+std::vector<Node*>
+FlowScene::
+pasteFragment(std::shared_ptr<SceneFragment const> fragment, QPointF mousePos)
+{
+  if (fragment->models.empty() && fragment->groups.isEmpty())
+    return {};
+
+  // Centre of the copied items lands under the mouse
+  std::vector<QPointF> corners = fragment->positions;
+  for (auto const &groupJson : fragment->groups)
+  {
+    QJsonObject positionJson = groupJson.toObject()["position"].toObject();
+    corners.emplace_back(positionJson["x"].toDouble(), positionJson["y"].toDouble());
+  }
+
+  QPointF minPos = corners.front();
+  QPointF maxPos = corners.front();
+  for (QPointF const &corner : corners)
+  {
+    minPos.setX(std::min(minPos.x(), corner.x()));
+    minPos.setY(std::min(minPos.y(), corner.y()));
+    maxPos.setX(std::max(maxPos.x(), corner.x()));
+    maxPos.setY(std::max(maxPos.y(), corner.y()));
+  }
+
+  QPointF const offset = mousePos - (minPos + maxPos) / 2.0;
+
+  std::vector<QUuid> groupIds;
+
+  // Nodes compute after all the connections exist, sources first
+  suspendPropagation();
+  std::vector<Node*> created = instantiateFragment(*fragment, offset, {}, groupIds);
+  resumePropagation();
+
+  std::vector<QUuid> nodeIds;
+  nodeIds.reserve(created.size());
+  for (Node *node : created)
+    nodeIds.push_back(node->id());
+
+  pushCommand(std::make_unique<FragmentCommand>(std::move(fragment),
+                                                offset,
+                                                std::move(nodeIds),
+                                                std::move(groupIds),
+                                                "Created Node "));
+
+  return created;
+}
+
+
+std::vector<Node*>
+FlowScene::
+instantiateFragment(SceneFragment const &fragment,
+                    QPointF offset,
+                    std::vector<QUuid> const &nodeIds,
+                    std::vector<QUuid> &groupIds)
+{
+  std::vector<Node*> created;
+  created.reserve(fragment.models.size());
+
+  for (std::size_t i = 0; i < fragment.models.size(); ++i)
+  {
+    NodeDataModel const &model = *fragment.models[i];
+
+    // The fragment stays untouched, every instance gets its own state
+    std::unique_ptr<NodeDataModel> copy = model.clone();
+    copy->restore(model.save());
+
+    Node &node = nodeIds.empty() ?
+                 createNode(std::move(copy)) :
+                 createNodeWithID(std::move(copy), nodeIds[i]);
+    node.nodeGraphicsObject().setPos(fragment.positions[i] + offset);
+
+    created.push_back(&node);
+  }
+
+  for (auto const &entry : fragment.connections)
+  {
+    createConnection(*created[entry.inNode], entry.inPort,
+                     *created[entry.outNode], entry.outPort);
+  }
+
+  groupIds.clear();
+  for (auto const &groupJson : fragment.groups)
+  {
+    Group &group = pasteGroup(groupJson.toObject(), QPointF(), offset);
+    groupIds.push_back(group.id());
+  }
+
+  return created;
+}
+
+
 void FlowScene::deleteJsonElements(const QJsonObject &jsonDocument)
 {
+  suspendPropagation();
+
   QJsonArray nodesJsonArray = jsonDocument["nodes"].toArray();
   for (int i = 0; i < nodesJsonArray.size(); ++i)
   {
@@ -1364,9 +2091,124 @@ void FlowScene::deleteJsonElements(const QJsonObject &jsonDocument)
     QUuid id = QUuid( nodeJson["id"].toString() );
     removeNodeWithID(id);
   }
+
+  resumePropagation();
+}
+
+
+void
+FlowScene::
+suspendPropagation()
+{
+  ++_propagationSuspended;
 }
 
 
+void
+FlowScene::
+resumePropagation()
+{
+  if (_propagationSuspended == 0 || --_propagationSuspended > 0)
+    return;
+
+  if (_pendingPropagation.empty())
+    return;
+
+  // One wave in dependency order. The outputs of a node are held back
+  // too, they reach a later node together with its other inputs.
+  ++_propagationSuspended;
+
+  // Only the nodes with held back inputs and what is downstream of them
+  std::vector<Node*> sources;
+  for (auto const &entry : _pendingPropagation)
+  {
+    if (!sources.empty() && sources.back()->id() == entry.first.first)
+      continue;
+
+    auto it = _nodes.find(entry.first.first);
+    if (it != _nodes.end())
+      sources.push_back(it->second.get());
+  }
+
+  for (Node *node : dependencyOrder(sources))
+  {
+    if (_pendingPropagation.empty())
+      break;
+
+    auto first = _pendingPropagation.lower_bound(
+      std::make_pair(node->id(), std::numeric_limits<PortIndex>::min()));
+
+    auto last = first;
+    while (last != _pendingPropagation.end() && last->first.first == node->id())
+      ++last;
+
+    if (first == last)
+      continue;
+
+    std::vector<std::pair<PortIndex, std::shared_ptr<NodeData>>> inputs;
+    for (auto it = first; it != last; ++it)
+      inputs.emplace_back(it->first.second, std::move(it->second));
+
+    _pendingPropagation.erase(first, last);
+
+    _deliveringNode = node;
+
+    for (auto &input : inputs)
+      node->propagateData(std::move(input.second), input.first);
+
+    _deliveringNode = nullptr;
+  }
+
+  --_propagationSuspended;
+
+  // Left over by cycles or deleted nodes, propagation runs normally again
+  auto pending = std::move(_pendingPropagation);
+  _pendingPropagation.clear();
+
+  for (auto &entry : pending)
+  {
+    auto it = _nodes.find(entry.first.first);
+
+    // Nodes deleted while suspended are skipped
+    if (it != _nodes.end())
+      it->second->propagateData(entry.second, entry.first.second);
+  }
+}
+
+
+bool
+FlowScene::
+isPropagationSuspended() const
+{
+  return _propagationSuspended > 0;
+}
+
+
+bool
+FlowScene::
+defersPropagationTo(Node const &node) const
+{
+  return _propagationSuspended > 0 && &node != _deliveringNode;
+}
+
+
+void
+FlowScene::
+deferPropagation(Node const &node,
+                 std::shared_ptr<NodeData> nodeData,
+                 PortIndex inPortIndex)
+{
+  _pendingPropagation[std::make_pair(node.id(), inPortIndex)] = std::move(nodeData);
+}
+
+
+QtNodes::PropagationTrace &
+FlowScene::
+propagationTrace()
+{
+  return _propagationTrace;
+}
+
 
 //------------------------------------------------------------------------------
 namespace QtNodes
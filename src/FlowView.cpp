@@ -26,18 +26,95 @@
 
 #include "Connection.hpp"
 #include "NodeConnectionInteraction.hpp"
+#include "SceneFragment.hpp"
 
 using QtNodes::FlowView;
 using QtNodes::FlowScene;
 using QtNodes::Connection;
 using QtNodes::NodeConnectionInteraction;
+using QtNodes::SceneDiffCommand;
 using QtNodes::NodeGraphicsObject;
+using QtNodes::SceneFragment;
+
+namespace
+{
+
+// Compressed compact JSON of the copied elements, for other instances
+QString const flowMimeType  = QStringLiteral("application/x-nodeeditor-flow");
+
+// Identifies the copy of the FlowView that owns the cloned fragment
+QString const tokenMimeType = QStringLiteral("application/x-nodeeditor-token");
+
+QString const textMimeType  = QStringLiteral("text/plain");
+
+
+// Copied elements, serialized only once another application or instance
+// asks for them. Pasting into this process only reads the token.
+class FragmentMimeData : public QMimeData
+{
+public:
+
+  FragmentMimeData(std::shared_ptr<SceneFragment const> fragment, QByteArray token)
+    : _fragment(std::move(fragment))
+    , _token(std::move(token))
+  {}
+
+  QStringList
+  formats() const override
+  { return { flowMimeType, tokenMimeType, textMimeType }; }
+
+  bool
+  hasFormat(QString const &mimeType) const override
+  { return mimeType == flowMimeType || mimeType == tokenMimeType || mimeType == textMimeType; }
+
+protected:
+
+  QVariant
+  retrieveData(QString const &mimeType, QVariant::Type type) const override
+  {
+    if (mimeType == tokenMimeType)
+      return _token;
+
+    if (mimeType == flowMimeType)
+      return qCompress(json());
+
+    if (mimeType == textMimeType)
+      return QString::fromUtf8(json());
+
+    return QMimeData::retrieveData(mimeType, type);
+  }
+
+private:
+
+  QByteArray const &
+  json() const
+  {
+    if (_json.isEmpty())
+      _json = QJsonDocument(_fragment->toJson()).toJson(QJsonDocument::Compact);
+
+    return _json;
+  }
+
+private:
+
+  std::shared_ptr<SceneFragment const> _fragment;
+
+  QByteArray _token;
+
+  mutable QByteArray _json;
+};
+
+}
 
 FlowView::
 FlowView(QWidget *parent)
   : QGraphicsView(parent)
   , _clearSelectionAction(Q_NULLPTR)
   , _deleteSelectionAction(Q_NULLPTR)
+  , _modelMenu(Q_NULLPTR)
+  , _modelMenuFilter(Q_NULLPTR)
+  , _modelMenuRegistry(Q_NULLPTR)
+  , _modelMenuRevision(0)
   , _scene(Q_NULLPTR)
 {
   setDragMode(QGraphicsView::ScrollHandDrag);
@@ -220,78 +297,102 @@ contextMenuEvent(QContextMenuEvent *event)
     QGraphicsView::contextMenuEvent(event);
     return;
   }
-  
-  QMenu modelMenu;
+
+  _modelMenuScenePos = mapToScene(event->pos());
+
+  updateModelMenu();
+
+  // Shows every entry again
+  _modelMenuFilter->clear();
+  filterModelMenu(QString());
+
+  // make sure the text box gets focus so the user doesn't have to click on it
+  _modelMenuFilter->setFocus();
+  _modelMenu->exec(event->globalPos());
+}
+
+
+void
+FlowView::
+updateModelMenu()
+{
+  DataModelRegistry const &registry = _scene->registry();
+
+  // The menu is kept between right clicks and only rebuilt
+  // when models or templates were registered since
+  if (_modelMenu &&
+      _modelMenuRegistry == &registry &&
+      _modelMenuRevision == registry.palette().revision())
+    return;
+
+  delete _modelMenu;
+
+  _modelMenu = new QMenu(this);
+  _modelMenuRegistry = &registry;
+  _modelMenuRevision = registry.palette().revision();
 
   auto skipText = QStringLiteral("skip me");
 
   //Add filterbox to the context menu
-  auto *txtBox = new QLineEdit(&modelMenu);
+  _modelMenuFilter = new QLineEdit(_modelMenu);
 
-  txtBox->setPlaceholderText(QStringLiteral("Filter"));
-  txtBox->setClearButtonEnabled(true);
+  _modelMenuFilter->setPlaceholderText(QStringLiteral("Filter"));
+  _modelMenuFilter->setClearButtonEnabled(true);
 
-  auto *txtBoxAction = new QWidgetAction(&modelMenu);
-  txtBoxAction->setDefaultWidget(txtBox);
+  auto *txtBoxAction = new QWidgetAction(_modelMenu);
+  txtBoxAction->setDefaultWidget(_modelMenuFilter);
 
-  modelMenu.addAction(txtBoxAction);
+  _modelMenu->addAction(txtBoxAction);
 
   //Add result treeview to the context menu
-  auto *treeView = new QTreeWidget(&modelMenu);
+  auto *treeView = new QTreeWidget(_modelMenu);
   treeView->header()->close();
 
-  auto *treeViewAction = new QWidgetAction(&modelMenu);
+  auto *treeViewAction = new QWidgetAction(_modelMenu);
   treeViewAction->setDefaultWidget(treeView);
 
-  modelMenu.addAction(treeViewAction);
+  _modelMenu->addAction(treeViewAction);
 
-  QMap<QString, QTreeWidgetItem*> topLevelItems;
-  for (auto const &cat : _scene->registry().categories())
+  _modelMenuCategories.clear();
+  for (auto const &cat : registry.categories())
   {
     auto item = new QTreeWidgetItem(treeView);
     item->setText(0, cat);
     item->setData(0, Qt::UserRole, skipText);
-    topLevelItems[cat] = item;
+    _modelMenuCategories[cat] = item;
   }
 
   //Add templates category
   auto templatesCategory = new QTreeWidgetItem(treeView);
   templatesCategory->setText(0, "Templates");
   templatesCategory->setData(0, Qt::UserRole, "Templates");
-  topLevelItems["Templates"] = templatesCategory;
+  _modelMenuCategories["Templates"] = templatesCategory;
+
+  // One item per palette entry, indexed by entry id
+  auto const &entries = registry.palette().entries();
 
-  for (auto const &assoc : _scene->registry().registeredModelsCategoryAssociation())
+  _modelMenuItems.assign(entries.size(), nullptr);
+  for (std::size_t id = 0; id < entries.size(); ++id)
   {
-    auto parent = topLevelItems[assoc.second];
+    auto const &entry = entries[id];
+    if (entry.removed)
+      continue;
+
+    auto parent = entry.isTemplate ? templatesCategory : _modelMenuCategories[entry.category];
     auto item   = new QTreeWidgetItem(parent);
-    item->setText(0, assoc.first);
-    item->setData(0, Qt::UserRole, assoc.first);
-  }
-  
-  for (auto const &assoc : _scene->registry().RegisteredTemplates())
-  {
-    QString name = assoc.first;
-    auto item   = new QTreeWidgetItem(templatesCategory);
-    item->setText(0, name);
-    item->setData(0, Qt::UserRole, name);
+    item->setText(0, entry.name);
+    item->setData(0, Qt::UserRole, entry.name);
+    _modelMenuItems[id] = item;
   }
 
-  //Add templates category
-  // auto GroupsCategory = new QTreeWidgetItem(treeView);
-  // GroupsCategory->setText(0, "Groups");
-  // GroupsCategory->setData(0, Qt::UserRole, "Groups");
-  // topLevelItems["Groups"] = GroupsCategory;
-
   auto groupItem   = new QTreeWidgetItem(treeView);
   groupItem->setText(0, "Group");
   groupItem->setData(0, Qt::UserRole, "Group");
-  topLevelItems["Group"] = groupItem;
-  
+  _modelMenuCategories["Group"] = groupItem;
 
   treeView->expandAll();
 
-
-  connect(treeView, &QTreeWidget::itemActivated, [&](QTreeWidgetItem *item, int)
+  connect(treeView, &QTreeWidget::itemActivated, this, [this, skipText](QTreeWidgetItem *item, int)
   {
     QString modelName = item->data(0, Qt::UserRole).toString();
 
@@ -303,10 +404,8 @@ contextMenuEvent(QContextMenuEvent *event)
     if(modelName == "Group")
     {
       Group& group = _scene->createGroup();
-      QPoint pos = event->pos();
-      QPointF posView = this->mapToScene(pos);
-      group.groupGraphicsObject().setPos(posView);
-      modelMenu.close();
+      group.groupGraphicsObject().setPos(_modelMenuScenePos);
+      _modelMenu->close();
       return;
     }
 
@@ -315,20 +414,15 @@ contextMenuEvent(QContextMenuEvent *event)
       QString parent = item->parent()->data(0, Qt::UserRole).toString();
       if(parent == "Templates")
       {
-        DataModelRegistry::RegisteredTemplatesMap map = _scene->registry().RegisteredTemplates();
-        QString fileName = map[modelName];
-
-        QFile file;
-        file.setFileName(fileName);
-        file.open(QIODevice::ReadOnly | QIODevice::Text);
-        QString val = file.readAll();
-        file.close();
-        qWarning() << val;
-        QJsonDocument d = QJsonDocument::fromJson(val.toUtf8());
-        QJsonObject sett2 = d.object();
-        jsonToSceneMousePos(sett2);
-
-        modelMenu.close();
+        // Parsed once by the registry, shared by every insertion
+        auto definition = _scene->registry().templateDefinition(modelName);
+        if (definition)
+          _scene->pasteFragment(definition, mouseScenePos());
+        else
+          qWarning() << "Template not found:" << modelName;
+
+        _modelMenu->close();
+        return;
       }
     }
 
@@ -337,75 +431,72 @@ contextMenuEvent(QContextMenuEvent *event)
     if (type)
     {
       Node& node = _scene->createNode(std::move(type));
-      QPoint pos = event->pos();
-      QPointF posView = this->mapToScene(pos);
-      node.nodeGraphicsObject().setPos(posView);
-
-      QUuid id = node.id();
-      _scene->AddAction(UndoRedoAction(
-        [this, id](void *ptr)
-        {
-          _scene->removeNodeWithID(id);
-          return 0;
-        },
-        [this, pos, modelName, id](void *ptr)
-        {
-          auto type = _scene->registry().create(modelName);
-          auto& node = _scene->createNodeWithID(std::move(type), id);
-          QPointF posView = this->mapToScene(pos);
-          node.nodeGraphicsObject().setPos(posView);    
-          return 0;
-        },
-        "Created Node " + node.nodeDataModel()->name()
-      ));
+      node.nodeGraphicsObject().setPos(_modelMenuScenePos);
+
+      QJsonObject created;
+      created["nodes"] = QJsonArray({ node.save() });
+      _scene->pushCommand(std::make_unique<SceneDiffCommand>(SceneDiffCommand::Kind::Added,
+                                                             created,
+                                                             "Created Node " + node.nodeDataModel()->name()));
     }
     else
     {
       qDebug() << "Model not found";
     }
 
-    modelMenu.close();
+    _modelMenu->close();
   });
 
   //Setup filtering
-  connect(txtBox, &QLineEdit::textChanged, [&](const QString &text)
+  connect(_modelMenuFilter, &QLineEdit::textChanged, this, &FlowView::filterModelMenu);
+
+  connect(_modelMenuFilter, &QLineEdit::returnPressed, this, [this]() {
+    QString text = _modelMenuFilter->text();
+    emit nodeNotFound(text);
+    _modelMenu->close();
+  });
+}
+
+
+void
+FlowView::
+filterModelMenu(QString const &text)
+{
+  std::vector<char> visible(_modelMenuItems.size(), 0);
+
+  for (std::size_t id : _scene->registry().palette().search(text))
+  {
+    if (id < visible.size())
+      visible[id] = 1;
+  }
+
+  // Only the items whose state changes are touched
+  for (std::size_t id = 0; id < _modelMenuItems.size(); ++id)
+  {
+    QTreeWidgetItem *item = _modelMenuItems[id];
+    if (item && item->isHidden() == bool(visible[id]))
+      item->setHidden(!visible[id]);
+  }
+
+  for (auto& topLvlItem : _modelMenuCategories)
   {
-    for (auto& topLvlItem : topLevelItems)
+    bool shouldHideCategory = true;
+    for (int i = 0; i < topLvlItem->childCount(); ++i)
     {
-      bool shouldHideCategory = true;
-      for (int i = 0; i < topLvlItem->childCount(); ++i)
-      {
-        auto child = topLvlItem->child(i);
-        auto modelName = child->data(0, Qt::UserRole).toString();
-        if (modelName.contains(text, Qt::CaseInsensitive))
-        {
-          shouldHideCategory = false;
-          child->setHidden(false);
-        }
-        else
-        {
-          child->setHidden(true);
-        }
-      }
-      auto catName = topLvlItem->data(0, Qt::UserRole).toString();
-      if(catName.contains(text, Qt::CaseInsensitive))
+      if (!topLvlItem->child(i)->isHidden())
       {
-        shouldHideCategory=false;
+        shouldHideCategory = false;
+        break;
       }
-
-      topLvlItem->setHidden(shouldHideCategory);
     }
-  });
-
-  connect(txtBox, &QLineEdit::returnPressed, [&]() {
-    QString text = txtBox->text();
-    emit nodeNotFound(text);
-    modelMenu.close();
-  });
+    auto catName = topLvlItem->text(0);
+    if(catName.contains(text, Qt::CaseInsensitive))
+    {
+      shouldHideCategory=false;
+    }
 
-  // make sure the text box gets focus so the user doesn't have to click on it
-  txtBox->setFocus();
-  modelMenu.exec(event->globalPos());
+    topLvlItem->setHidden(shouldHideCategory);
+  }
 }
 
 
@@ -462,19 +553,19 @@ scaleDown()
 
 
 void FlowView::jsonToSceneMousePos(QJsonObject jsonDocument) {
-    QPoint viewPointMouse = this->mapFromGlobal(QCursor::pos());
-    QPointF posViewMouse = this->mapToScene(viewPointMouse);       
-    _scene->jsonToSceneMousePos(jsonDocument, posViewMouse);
+    _scene->jsonToSceneMousePos(jsonDocument, mouseScenePos());
 }
 
 void FlowView::copySelectedNodes() {
-  QJsonObject sceneJson = _scene->selectionToJson();
+  // Pasting into this process goes through the cloned models, the
+  // token tells whether the clipboard still holds our own copy
+  _clipboardFragment = _scene->copyFragment();
+  _clipboardToken = QUuid::createUuid().toRfc4122();
 
-  QJsonDocument document(sceneJson);
-  std::string json = document.toJson().toStdString();
+  auto mimeData = new FragmentMimeData(_clipboardFragment, _clipboardToken);
 
   QClipboard *p_Clipboard = QApplication::clipboard();
-  p_Clipboard->setText( QString::fromStdString(json));
+  p_Clipboard->setMimeData(mimeData);
 }
 
 
@@ -484,20 +575,42 @@ void FlowView::copySelectedNodes() {
 
 void FlowView::pasteSelectedNodes() {
     QClipboard *p_Clipboard = QApplication::clipboard();  
-    QByteArray text = p_Clipboard->text().toUtf8();
+    QMimeData const *mimeData = p_Clipboard->mimeData();
 
-    QJsonObject const jsonDocument = QJsonDocument::fromJson(text).object();
-    jsonToSceneMousePos(jsonDocument);
-    
+    if (!mimeData)
+      return;
 
+    if (_clipboardFragment &&
+        mimeData->data(tokenMimeType) == _clipboardToken)
+    {
+      _scene->pasteFragment(_clipboardFragment, mouseScenePos());
+      return;
+    }
+
+    // Copied by another instance, or by text
+    QByteArray json;
+    if (mimeData->hasFormat(flowMimeType))
+      json = qUncompress(mimeData->data(flowMimeType));
+    else
+      json = mimeData->text().toUtf8();
+
+    QJsonObject const jsonDocument = QJsonDocument::fromJson(json).object();
+    jsonToSceneMousePos(jsonDocument);
 }
 
 
 
 void FlowView::duplicateSelectedNode()
 {
-  QJsonObject selectionJson = _scene->selectionToJson();
-  jsonToSceneMousePos(selectionJson);
+  _scene->pasteFragment(_scene->copyFragment(), mouseScenePos());
+}
+
+
+QPointF
+FlowView::
+mouseScenePos() const
+{
+  return mapToScene(mapFromGlobal(QCursor::pos()));
 }
 
 
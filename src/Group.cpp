@@ -1,8 +1,86 @@
 #include "Group.hpp"
+#include "GroupEvaluator.hpp"
 #include "GroupGraphicsObject.hpp"
 #include "FlowScene.hpp"
 
 using QtNodes::Group;
+using QtNodes::GroupEvaluator;
+using QtNodes::Node;
+using QtNodes::Connection;
+using QtNodes::PortType;
+
+Group::
+Group(FlowScene &scene)
+  : _groupGraphicsObject(nullptr)
+  , _name("New Group")
+  , _scene(scene)
+  , _compiled(false)
+  , _id(QUuid::createUuid())
+{}
+
+
+Group::
+~Group() = default;
+
+
+void
+Group::
+addNode(Node *node)
+{
+  _nodes.insert(node);
+  _evaluator.reset();
+}
+
+
+void
+Group::
+removeNode(Node *node)
+{
+  _nodes.erase(node);
+  _evaluator.reset();
+}
+
+
+void
+Group::
+addConnection(Connection *connection, PortType portType)
+{
+  _connections[(int)portType].insert(connection);
+  _evaluator.reset();
+}
+
+
+void
+Group::
+removeConnection(Connection *connection, PortType portType)
+{
+  _connections[(int)portType].erase(connection);
+  _evaluator.reset();
+}
+
+
+void
+Group::
+setCompiled(bool compiled)
+{
+  _compiled = compiled;
+  _evaluator.reset();
+}
+
+
+GroupEvaluator*
+Group::
+evaluator()
+{
+  if (!_compiled || !_groupGraphicsObject->isCollapsed())
+    return nullptr;
+
+  if (!_evaluator)
+    _evaluator = std::make_unique<GroupEvaluator>(*this);
+
+  return _evaluator->isValid() ? _evaluator.get() : nullptr;
+}
+
 
 QUuid
 Group::
@@ -44,6 +122,7 @@ restore(QJsonObject const &json){
 
   SetName(json["name"].toString());
   _groupGraphicsObject->nameLineEdit->setText(_name);
+  setCompiled((bool)json["compiled"].toInt());
   
   
   Group &groupRef = *(this);
@@ -73,6 +152,7 @@ restoreAtPosition(QJsonObject const &json, QPointF position){
 
   SetName(json["name"].toString());
   _groupGraphicsObject->nameLineEdit->setText(_name);
+  setCompiled((bool)json["compiled"].toInt());
   
   // "Problem : when restoring the group, it doesn't see the nodes that are within it."
   
@@ -0,0 +1,168 @@
+#include "GroupEvaluator.hpp"
+
+#include <algorithm>
+#include <deque>
+
+#include "Connection.hpp"
+#include "FlowScene.hpp"
+#include "Group.hpp"
+#include "Node.hpp"
+#include "NodeDataModel.hpp"
+#include "NodeGraphicsObject.hpp"
+#include "PropagationTrace.hpp"
+
+using QtNodes::GroupEvaluator;
+using QtNodes::Group;
+using QtNodes::Node;
+using QtNodes::NodeData;
+using QtNodes::NodeDataModel;
+using QtNodes::Connection;
+using QtNodes::PropagationTrace;
+using QtNodes::PortIndex;
+using QtNodes::PortType;
+
+GroupEvaluator::
+GroupEvaluator(Group const &group)
+  : _valid(false)
+{
+  std::vector<Node*> const nodes(group.nodes().begin(), group.nodes().end());
+
+  std::unordered_map<Node const*, std::size_t> indices;
+  for (std::size_t i = 0; i < nodes.size(); ++i)
+    indices[nodes[i]] = i;
+
+  // Inner edges, as (source, destination) node indices
+  std::vector<std::vector<std::size_t>> successors(nodes.size());
+  std::vector<std::size_t> pendingInputs(nodes.size(), 0);
+
+  for (Connection *connection : group.connections(PortType::None))
+  {
+    std::size_t const source      = indices.at(connection->getNode(PortType::Out));
+    std::size_t const destination = indices.at(connection->getNode(PortType::In));
+
+    successors[source].push_back(destination);
+    ++pendingInputs[destination];
+  }
+
+  // Kahn's algorithm, a node comes after all of its inner sources
+  std::vector<std::size_t> order;
+  order.reserve(nodes.size());
+
+  std::deque<std::size_t> ready;
+  for (std::size_t i = 0; i < nodes.size(); ++i)
+  {
+    if (pendingInputs[i] == 0)
+      ready.push_back(i);
+  }
+
+  while (!ready.empty())
+  {
+    std::size_t const i = ready.front();
+    ready.pop_front();
+
+    order.push_back(i);
+
+    for (std::size_t successor : successors[i])
+    {
+      if (--pendingInputs[successor] == 0)
+        ready.push_back(successor);
+    }
+  }
+
+  if (order.size() != nodes.size())
+    return;
+
+  _steps.resize(nodes.size());
+  for (std::size_t step = 0; step < order.size(); ++step)
+  {
+    _steps[step].node = nodes[order[step]];
+    _stepIndices[nodes[order[step]]] = step;
+  }
+
+  for (Connection *connection : group.connections(PortType::None))
+  {
+    Step &step = _steps[_stepIndices.at(connection->getNode(PortType::In))];
+
+    step.inputs.push_back(Input{ connection->getPortIndex(PortType::In),
+                                 _stepIndices.at(connection->getNode(PortType::Out)),
+                                 connection->getPortIndex(PortType::Out) });
+  }
+
+  for (Connection *connection : group.connections(PortType::Out))
+  {
+    Step &step = _steps[_stepIndices.at(connection->getNode(PortType::Out))];
+
+    step.outputs.emplace_back(connection->getPortIndex(PortType::Out), connection);
+  }
+
+  _dirty.resize(_steps.size(), 0);
+  _valid = true;
+}
+
+
+void
+GroupEvaluator::
+propagate(Node const &node,
+          std::shared_ptr<NodeData> nodeData,
+          PortIndex inPortIndex)
+{
+  auto it = _stepIndices.find(&node);
+  if (!_valid || it == _stepIndices.end())
+    return;
+
+  std::size_t const first = it->second;
+
+  // Inner deliveries show up in the timeline like Node::propagateData ones
+  PropagationTrace &trace =
+    _steps[first].node->nodeGraphicsObject().flowScene().propagationTrace();
+
+  std::vector<std::pair<Connection*, std::shared_ptr<NodeData>>> leaving;
+
+  for (std::size_t i = first; i < _steps.size(); ++i)
+  {
+    Step const &step = _steps[i];
+    NodeDataModel &model = *step.node->nodeDataModel();
+
+    // Results are pulled in order below, the signals would only
+    // propagate them a second time
+    bool const blocked = model.blockSignals(true);
+
+    if (i == first)
+    {
+      PropagationTrace::Scope traceScope(trace, *step.node, inPortIndex, !nodeData);
+
+      model.setInData(nodeData, inPortIndex);
+      _dirty[i] = 1;
+    }
+    else
+    {
+      for (Input const &input : step.inputs)
+      {
+        if (!_dirty[input.sourceStep])
+          continue;
+
+        NodeDataModel &source = *_steps[input.sourceStep].node->nodeDataModel();
+        std::shared_ptr<NodeData> data = source.outData(input.sourcePort);
+
+        PropagationTrace::Scope traceScope(trace, *step.node, input.inPort, !data);
+
+        model.setInData(std::move(data), input.inPort);
+        _dirty[i] = 1;
+      }
+    }
+
+    model.blockSignals(blocked);
+
+    if (_dirty[i])
+    {
+      for (auto const &output : step.outputs)
+        leaving.emplace_back(output.second, model.outData(output.first));
+    }
+  }
+
+  std::fill(_dirty.begin() + first, _dirty.end(), 0);
+
+  // Downstream nodes may feed the group again, the evaluator is idle by now
+  for (auto const &pair : leaving)
+    pair.first->propagateData(pair.second);
+}
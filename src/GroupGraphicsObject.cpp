@@ -1,7 +1,9 @@
 #include "GroupGraphicsObject.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <cstdlib>
+#include <tuple>
 
 #include <QtWidgets/QtWidgets>
 #include <QtWidgets/QGraphicsEffect>
@@ -25,6 +27,7 @@ using QtNodes::Group;
 using QtNodes::FlowScene;
 using QtNodes::Connection;
 using QtNodes::PortType;
+using QtNodes::PortIndex;
 
 GroupGraphicsObject::
 GroupGraphicsObject(FlowScene &scene, Group& group)
@@ -90,89 +93,42 @@ void
 GroupGraphicsObject::
 Collapse()
 {
-	unusedConnections.clear();
-
-	////1. Identify all the nodes that have external inputs
-	inOutLabels[(int)PortType::In].clear();
-	inOutConnections[(int)PortType::In].clear();
-	inOutNodes[(int)PortType::In].clear();
-	inOutPorts[(int)PortType::In].clear();
-	//for all the nodes in the group
-	for (int i = 0; i < childItems().size(); i++)
+	// Ports of the collapsed group, one per connection crossing its border.
+	// FlowScene keeps these connections up to date, nothing is scanned here
+	for (PortType portType : { PortType::In, PortType::Out })
 	{
-		NodeGraphicsObject* nodeGO = qgraphicsitem_cast<NodeGraphicsObject*>(childItems()[i]);
-		if (nodeGO != nullptr)
+		inOutLabels[(int)portType].clear();
+		inOutConnections[(int)portType].clear();
+		inOutNodes[(int)portType].clear();
+		inOutPorts[(int)portType].clear();
+
+		std::vector<Connection*> boundary(_group.connections(portType).begin(),
+		                                  _group.connections(portType).end());
+
+		// Same port order on every collapse: by inner node, port and connection
+		std::sort(boundary.begin(), boundary.end(),
+		          [portType](Connection const *a, Connection const *b)
+		          {
+		            return std::make_tuple(a->getNode(portType)->id(), a->getPortIndex(portType), a->id()) <
+		                   std::make_tuple(b->getNode(portType)->id(), b->getPortIndex(portType), b->id());
+		          });
+
+		for (Connection *connection : boundary)
 		{
-			Node &node = nodeGO->node();
-			int numEntries = node.nodeState().getEntries(PortType::In).size();
-
-			//For each input of the current node
-			for (int j = 0; j < numEntries; j++)
-			{
-				NodeState::ConnectionPtrSet connections = node.nodeState().connections(PortType::In, j);
-				//Get the connection
-				for (std::pair<QUuid, Connection*> connectionPair : connections)
-				{
-					Connection *connection = connectionPair.second;
-					Node *sourceNode = connection->getNode(PortType::Out);
-					Node *destNode = connection->getNode(PortType::In);
-					NodeGraphicsObject &sourceNodeGO = sourceNode->nodeGraphicsObject();
-
-					//Check if the the input is inside the group
-					if (childItems().indexOf(&sourceNodeGO) == -1) { //if it's not inside
-						inOutLabels[(int)PortType::In].push_back(
-							node.nodeDataModel()->name() + "." + node.nodeDataModel()->portCaption(PortType::In, j)
-						);
-						inOutConnections[(int)PortType::In].push_back(connection);
-						inOutNodes[(int)PortType::In].push_back(destNode);
-						inOutPorts[(int)PortType::In].push_back(j);
-					}
-					else { //it's inside
-						unusedConnections.push_back(connection);
-					}
-				}
-			}
-		}
-	}
-
-	////2. Identify all the nodes that have external outputs
-	inOutLabels[(int)PortType::Out].clear();
-	inOutConnections[(int)PortType::Out].clear();
-	inOutNodes[(int)PortType::Out].clear();
-	inOutPorts[(int)PortType::Out].clear();
-	//for all the nodes in the group
-	for (int i = 0; i < childItems().size(); i++)
-	{
-		NodeGraphicsObject* nodeGO = qgraphicsitem_cast<NodeGraphicsObject*>(childItems()[i]);
-		if (nodeGO != nullptr)
-		{
-			Node &node = nodeGO->node();
-			int numOutputs = node.nodeState().getEntries(PortType::Out).size();
-			for (int j = 0; j < numOutputs; j++)
-			{
-				NodeState::ConnectionPtrSet connections = node.nodeState().connections(PortType::Out, j);
-				for (std::pair<QUuid, Connection*> connectionPair : connections)
-				{
-					Connection *connection = connectionPair.second;
-					Node *destNode = connection->getNode(PortType::In);
-					NodeGraphicsObject &destNodeGO = destNode->nodeGraphicsObject();
-
-					if (childItems().indexOf(&destNodeGO) == -1) {
-						inOutLabels[(int)PortType::Out].push_back(
-							node.nodeDataModel()->name() + "." + node.nodeDataModel()->portCaption(PortType::Out, j)
-						);
-						inOutConnections[(int)PortType::Out].push_back(connection);
-						inOutNodes[(int)PortType::Out].push_back(destNode);
-						inOutPorts[(int)PortType::Out].push_back(j);
-					}
-					else {
-						unusedConnections.push_back(connection);
-					}
-				}
-			}
+			Node &node = *connection->getNode(portType);
+			PortIndex port = connection->getPortIndex(portType);
+
+			inOutLabels[(int)portType].push_back(
+				node.nodeDataModel()->name() + "." + node.nodeDataModel()->portCaption(portType, port)
+			);
+			inOutConnections[(int)portType].push_back(connection);
+			inOutNodes[(int)portType].push_back(connection->getNode(PortType::In));
+			inOutPorts[(int)portType].push_back(port);
 		}
 	}
 
+	auto const &internal = _group.connections(PortType::None);
+	unusedConnections.assign(internal.begin(), internal.end());
 
   if(!collapsed)
   {
@@ -189,13 +145,9 @@ Collapse()
 
 
     //Sets the inside nodes invisible
-    for(int i=0; i<childItems().size(); i++)
+    for(Node *node : _group.nodes())
     {
-      NodeGraphicsObject* ngo = dynamic_cast<NodeGraphicsObject*>(childItems()[i]);
-      if(ngo!=nullptr)
-      {
-        childItems()[i]->setVisible(false);
-      }
+      node->nodeGraphicsObject().setVisible(false);
     }
 
     //Sets the inside connections invisible
@@ -237,15 +189,19 @@ Collapse()
     _proxyWidget->setPos(QPointF(sizeX/2 - _proxyWidget->size().width()/2, 0));
     _collapseButton->setPos(QPointF(sizeX - _collapseButton->size().width(), 0));
 
-    //Sets the inside nodes invisible
-    for(int i=0; i<childItems().size(); i++)
+    //Sets the inside nodes visible
+    for(Node *node : _group.nodes())
     {
-      NodeGraphicsObject* ngo = dynamic_cast<NodeGraphicsObject*>(childItems()[i]);
-      if(ngo!=nullptr)
+      node->nodeGraphicsObject().setVisible(true);
+
+      // A compiled group did not repaint its nodes while collapsed
+      if(_group.isCompiled())
       {
-        childItems()[i]->setVisible(true);
+        node->nodeGraphicsObject().setGeometryChanged();
+        node->nodeGeometry().recalculateSize();
+        node->nodeGraphicsObject().update();
       }
-    }    
+    }
 
     for(int i=0; i<unusedConnections.size(); i++)
     {
@@ -304,37 +260,36 @@ int GroupGraphicsObject::checkHitScenePoint(PortType portType,
 {
   auto const &nodeStyle = StyleCollection::nodeStyle();
 
-  PortIndex result = INVALID;
-
   if (portType == PortType::None)
-    return result;
+    return INVALID;
 
-  double const tolerance = 2.0 * nodeStyle.ConnectionPointDiameter;
+  int const nItems = static_cast<int>(inOutLabels[(int)portType].size());
 
-  size_t const nItems = inOutLabels[(int)portType].size();
+  if (nItems == 0 || spacing <= 0)
+    return INVALID;
 
-  for (size_t i = 0; i < nItems; ++i)
-  {
-    auto pp = portScenePosition(i, portType);
+  QPointF const point = scenePoint - scenePos();
 
-    QPointF p = pp - scenePoint;
-    auto    distance = std::sqrt(QPointF::dotProduct(p, p));
-    
-    if (distance < tolerance)
-    {
-      result = PortIndex(i);
-      break;
-    }
-  }
+  // Ports are spaced evenly from topPadding, only the nearest one can be hit
+  int const index = qBound(0, qRound((point.y() - topPadding) / double(spacing)), nItems - 1);
 
-  return result;
+  QPointF const diff = portPosition(index, portType) - point;
+
+  double const tolerance = 2.0 * nodeStyle.ConnectionPointDiameter;
+
+  if (QPointF::dotProduct(diff, diff) < tolerance * tolerance)
+    return PortIndex(index);
+
+  return INVALID;
 }
 
 
 GroupGraphicsObject::
 ~GroupGraphicsObject()
 {
-  _scene.removeItem(this);
+  // Children of a group item leave the scene together with it
+  if (scene())
+    _scene.removeItem(this);
 }
 
 
@@ -369,16 +324,12 @@ setGeometryChanged()
 void
 GroupGraphicsObject::
 moveConnections() const {
-  for(int i=0; i<childItems().size(); i++) {
-    NodeGraphicsObject* ngo = dynamic_cast<NodeGraphicsObject*>(childItems()[i]);
-    if (ngo) {
-      ngo->moveConnections();
-    }
+  for(Node *node : _group.nodes()) {
+    node->nodeGraphicsObject().moveConnections();
+  }
 
-    GroupGraphicsObject* ggo = dynamic_cast<GroupGraphicsObject*>(childItems()[i]);
-    if (ggo) {
-      ggo->moveConnections();
-    }
+  for(Group *group : _group.childGroups()) {
+    group->groupGraphicsObject().moveConnections();
   }
 }
 
@@ -441,6 +392,11 @@ QVariant
 GroupGraphicsObject::
 itemChange(GraphicsItemChange change, const QVariant &value)
 {
+  if (change == ItemScenePositionHasChanged && scene())
+  {
+    _scene.expandSceneRect(sceneBoundingRect());
+  }
+
   return QGraphicsItem::itemChange(change, value);
 }
 
@@ -463,6 +419,8 @@ mousePressEvent(QGraphicsSceneMouseEvent * event)
     _scene.clearSelection();
   }
 
+  _scene.beginMoveGesture(this);
+
   auto mousePos = event->pos();
 
   if (abs(mousePos.x() - sizeX) < 20 && abs(mousePos.y() - sizeY) < 20)
@@ -568,9 +526,9 @@ mouseMoveEvent(QGraphicsSceneMouseEvent * event)
     _collapseButton->setPos(QPointF(sizeX - _collapseButton->size().width(), 0));
     event->accept();    
   } else {
+    // Child nodes schedule their connections on scene position changes
     _scene.groupMoved(_group, pos());
     QGraphicsObject::mouseMoveEvent(event);
-    moveConnections();
   }
 }
 
@@ -581,6 +539,10 @@ mouseReleaseEvent(QGraphicsSceneMouseEvent* event)
 {
   QGraphicsObject::mouseReleaseEvent(event);
   _scene.groupMoveFinished(_group, pos(), oldPosition);
+  _scene.endMoveGesture();
+
+  // Covers resizing, moves are tracked by itemChange
+  _scene.expandSceneRect(sceneBoundingRect());
 
   isResizingX=false;
   isResizingY=false;
@@ -644,5 +606,14 @@ void
 GroupGraphicsObject::
 contextMenuEvent(QGraphicsSceneContextMenuEvent* event)
 {
+  QMenu menu;
+
+  QAction *compileAction = menu.addAction(tr("Evaluate as one node when collapsed"));
+  compileAction->setCheckable(true);
+  compileAction->setChecked(_group.isCompiled());
 
+  if (menu.exec(event->screenPos()) == compileAction)
+    _group.setCompiled(compileAction->isChecked());
+
+  event->accept();
 }
@@ -0,0 +1,185 @@
+#include "ModelPalette.hpp"
+
+#include <algorithm>
+
+using QtNodes::ModelPalette;
+
+void
+ModelPalette::
+addEntry(QString const &name, QString const &category, bool isTemplate)
+{
+  auto &ids = isTemplate ? _templateIds : _modelIds;
+
+  auto it = ids.find(name);
+  if (it != ids.end())
+  {
+    // Names are indexed already, a re-registration only revives the entry
+    Entry &entry = _entries[it->second];
+    entry.category = category;
+    entry.removed  = false;
+    ++_revision;
+    return;
+  }
+
+  std::size_t const id = _entries.size();
+
+  _entries.push_back(Entry{ name, category, isTemplate, false });
+  _lowerNames.push_back(name.toLower());
+  ids[name] = id;
+
+  for (Trigram trigram : trigrams(_lowerNames.back()))
+    _trigramIndex[trigram].push_back(id);
+
+  _sortedNames.emplace(_lowerNames.back(), id);
+
+  ++_revision;
+}
+
+
+void
+ModelPalette::
+removeEntry(QString const &name, bool isTemplate)
+{
+  auto &ids = isTemplate ? _templateIds : _modelIds;
+
+  auto it = ids.find(name);
+  if (it == ids.end())
+    return;
+
+  _entries[it->second].removed = true;
+  ++_revision;
+}
+
+
+std::vector<std::size_t>
+ModelPalette::
+search(QString const &text) const
+{
+  QString const query = text.toLower();
+
+  std::vector<std::size_t> ret;
+
+  if (query.isEmpty())
+  {
+    for (std::size_t id = 0; id < _entries.size(); ++id)
+    {
+      if (!_entries[id].removed)
+        ret.push_back(id);
+    }
+
+    return ret;
+  }
+
+  std::vector<char> found(_entries.size(), 0);
+
+  auto add = [&](std::size_t id)
+    {
+      if (found[id] || _entries[id].removed)
+        return;
+
+      found[id] = 1;
+      ret.push_back(id);
+    };
+
+  for (auto it = _sortedNames.lower_bound(std::make_pair(query, std::size_t(0)));
+       it != _sortedNames.end() && it->first.startsWith(query);
+       ++it)
+  {
+    add(it->second);
+  }
+
+  // Short queries match most names, there is nothing to narrow down
+  if (query.size() < 3)
+  {
+    for (std::size_t id = 0; id < _lowerNames.size(); ++id)
+    {
+      if (_lowerNames[id].contains(query))
+        add(id);
+    }
+
+    return ret;
+  }
+
+  std::vector<Trigram> const queryTrigrams = trigrams(query);
+
+  // Every match contains all the query trigrams, the rarest one is enough
+  std::vector<std::size_t> const *rarest = nullptr;
+
+  for (Trigram trigram : queryTrigrams)
+  {
+    auto it = _trigramIndex.find(trigram);
+    if (it == _trigramIndex.end())
+    {
+      rarest = nullptr;
+      break;
+    }
+
+    if (!rarest || it->second.size() < rarest->size())
+      rarest = &it->second;
+  }
+
+  if (rarest)
+  {
+    for (std::size_t id : *rarest)
+    {
+      if (_lowerNames[id].contains(query))
+        add(id);
+    }
+  }
+
+  if (!ret.empty())
+    return ret;
+
+  // Nothing contains the query, fall back to names sharing most trigrams
+  std::unordered_map<std::size_t, std::size_t> shared;
+
+  for (Trigram trigram : queryTrigrams)
+  {
+    auto it = _trigramIndex.find(trigram);
+    if (it == _trigramIndex.end())
+      continue;
+
+    for (std::size_t id : it->second)
+      ++shared[id];
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> candidates;
+
+  for (auto const &pair : shared)
+  {
+    if (2 * pair.second >= queryTrigrams.size() && !_entries[pair.first].removed)
+      candidates.emplace_back(pair.second, pair.first);
+  }
+
+  std::sort(candidates.begin(), candidates.end(),
+            [](std::pair<std::size_t, std::size_t> const &a,
+               std::pair<std::size_t, std::size_t> const &b)
+            {
+              return a.first > b.first || (a.first == b.first && a.second < b.second);
+            });
+
+  for (auto const &candidate : candidates)
+    ret.push_back(candidate.second);
+
+  return ret;
+}
+
+
+std::vector<ModelPalette::Trigram>
+ModelPalette::
+trigrams(QString const &lowerName)
+{
+  std::vector<Trigram> ret;
+
+  for (int i = 0; i + 2 < lowerName.size(); ++i)
+  {
+    ret.push_back((Trigram(lowerName[i].unicode()) << 32) |
+                  (Trigram(lowerName[i + 1].unicode()) << 16) |
+                  Trigram(lowerName[i + 2].unicode()));
+  }
+
+  std::sort(ret.begin(), ret.end());
+  ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+
+  return ret;
+}
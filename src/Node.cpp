@@ -5,6 +5,8 @@
 #include <iostream>
 
 #include "FlowScene.hpp"
+#include "Group.hpp"
+#include "GroupEvaluator.hpp"
 
 #include "NodeGraphicsObject.hpp"
 #include "NodeDataModel.hpp"
@@ -12,6 +14,7 @@
 #include "ConnectionGraphicsObject.hpp"
 #include "ConnectionState.hpp"
 #include "Connection.hpp"
+#include "PropagationTrace.hpp"
 #include <QtWidgets/QGraphicsView>
 
 using QtNodes::Node;
@@ -20,10 +23,14 @@ using QtNodes::NodeState;
 using QtNodes::NodeData;
 using QtNodes::NodeDataType;
 using QtNodes::NodeDataModel;
+using QtNodes::NodeValidationState;
 using QtNodes::NodeGraphicsObject;
 using QtNodes::PortIndex;
 using QtNodes::PortType;
 using QtNodes::Connection;
+using QtNodes::PropagationTrace;
+using QtNodes::Group;
+using QtNodes::GroupEvaluator;
 
 
 Node::
@@ -40,6 +47,18 @@ Node(std::unique_ptr<NodeDataModel> && dataModel)
   connect(_nodeDataModel.get(), &NodeDataModel::dataUpdated,
           this, &Node::onDataUpdated);
 
+  connect(_nodeDataModel.get(), &NodeDataModel::layoutChanged,
+          this, &Node::onLayoutChanged);
+
+  connect(_nodeDataModel.get(), &NodeDataModel::portInserted,
+          this, &Node::insertPort);
+
+  connect(_nodeDataModel.get(), &NodeDataModel::portAboutToBeRemoved,
+          this, &Node::erasePortConnections);
+
+  connect(_nodeDataModel.get(), &NodeDataModel::portRemoved,
+          this, &Node::removePort);
+
   this->inputSelected.resize(_nodeDataModel->nPorts(PortType::In));
 		
 }
@@ -100,8 +119,8 @@ Node::
 updateView()
 {
   nodeGraphicsObject().setGeometryChanged();
-  nodeGeometry().recalculateSize();
   nodeGeometry().recalculateInOut();
+  nodeGeometry().recalculateSize();
   nodeState().updateEntries();
 
   nodeGraphicsObject().update();
@@ -114,10 +133,7 @@ void
 Node::
 eraseInputAtIndex(int portIndex)
 {
-	std::unordered_map<QUuid, Connection*> connections = nodeState().connections(PortType::In, portIndex);
-	for (auto& connection : connections) {
-		nodeGraphicsObject().flowScene().deleteConnection(connection.second);
-	}
+  erasePortConnections(PortType::In, portIndex);
 }
 
 
@@ -210,6 +226,14 @@ nodeGraphicsObject()
 }
 
 
+NodeGraphicsObject *
+Node::
+releaseGraphicsObject()
+{
+  return _nodeGraphicsObject.release();
+}
+
+
 void
 Node::
 setGraphicsObject(std::unique_ptr<NodeGraphicsObject>&& graphics)
@@ -267,13 +291,52 @@ Node::
 propagateData(std::shared_ptr<NodeData> nodeData,
               PortIndex inPortIndex) const
 {
+  FlowScene &scene = _nodeGraphicsObject->flowScene();
+
+  if (scene.defersPropagationTo(*this))
+  {
+    scene.deferPropagation(*this, nodeData, inPortIndex);
+    return;
+  }
+
+  // Collapsed compiled groups evaluate their nodes themselves
+  if (Group *group = scene.nodeGroup(*this))
+  {
+    if (GroupEvaluator *evaluator = group->evaluator())
+    {
+      evaluator->propagate(*this, nodeData, inPortIndex);
+      return;
+    }
+  }
+
+  PropagationTrace::Scope traceScope(scene.propagationTrace(),
+                                     *this,
+                                     inPortIndex,
+                                     !nodeData);
+
+  QString const caption = _nodeDataModel->caption();
+  NodeValidationState const state = _nodeDataModel->validationState();
+  QString const message = _nodeDataModel->validationMessage();
+
   _nodeDataModel->setInData(nodeData, inPortIndex);
 
-  //Recalculate the nodes visuals. A data change can result in the node taking more space than before, so this forces a recalculate+repaint on the affected node
-  _nodeGraphicsObject->setGeometryChanged();
-  _nodeGeometry.recalculateSize();
+  // Most data leaves the layout as it is, models changing anything else
+  // than these emit layoutChanged, see onLayoutChanged
+  if (caption != _nodeDataModel->caption())
+  {
+    _nodeGraphicsObject->setGeometryChanged();
+    _nodeGeometry.recalculateSize();
+    _nodeGraphicsObject->scheduleMoveConnections();
+  }
+  else if (state != _nodeDataModel->validationState() ||
+           message != _nodeDataModel->validationMessage())
+  {
+    _nodeGraphicsObject->setGeometryChanged();
+    _nodeGeometry.updateSize();
+    _nodeGraphicsObject->scheduleMoveConnections();
+  }
+
   _nodeGraphicsObject->update();
-  _nodeGraphicsObject->moveConnections();
 }
 
 
@@ -300,3 +363,80 @@ onDataUpdatedConnection(PortIndex index, Connection* connection)
   auto nodeData = _nodeDataModel->outData(index);
   connection->propagateData(nodeData);
 }
+
+
+void
+Node::
+insertPort(PortType portType, PortIndex portIndex)
+{
+  _nodeState.insertPort(portType, portIndex);
+
+  if (portType == PortType::In && portIndex <= static_cast<PortIndex>(inputSelected.size()))
+    inputSelected.insert(inputSelected.begin() + portIndex, false);
+
+  _nodeGeometry.insertPort(portType, portIndex);
+
+  onPortsRenumbered();
+}
+
+
+void
+Node::
+erasePortConnections(PortType portType, PortIndex portIndex)
+{
+  // Deleting a connection erases it from the node state, iterate a copy
+  NodeState::ConnectionPtrSet const connections = _nodeState.connections(portType, portIndex);
+
+  for (auto const &connection : connections)
+    _nodeGraphicsObject->flowScene().deleteConnection(connection.second);
+}
+
+
+void
+Node::
+removePort(PortType portType, PortIndex portIndex)
+{
+  // Deleting them now would send empty data to a port the model no
+  // longer has, see NodeDataModel::portAboutToBeRemoved
+  Q_ASSERT(_nodeState.connections(portType, portIndex).empty());
+
+  _nodeState.removePort(portType, portIndex);
+
+  if (portType == PortType::In && portIndex < static_cast<PortIndex>(inputSelected.size()))
+    inputSelected.erase(inputSelected.begin() + portIndex);
+
+  _nodeGeometry.removePort(portType, portIndex);
+
+  onPortsRenumbered();
+}
+
+
+void
+Node::
+onPortsRenumbered()
+{
+  // A compiled group refers to the inner ports by index
+  if (Group *group = _nodeGraphicsObject->flowScene().nodeGroup(*this))
+    group->invalidateEvaluator();
+
+  _nodeGraphicsObject->setGeometryChanged();
+  _nodeGraphicsObject->update();
+  _nodeGraphicsObject->scheduleMoveConnections();
+}
+
+
+void
+Node::
+onLayoutChanged()
+{
+  if (!_nodeGraphicsObject)
+  {
+    _nodeGeometry.recalculateSize();
+    return;
+  }
+
+  _nodeGraphicsObject->setGeometryChanged();
+  _nodeGeometry.recalculateSize();
+  _nodeGraphicsObject->update();
+  _nodeGraphicsObject->scheduleMoveConnections();
+}
@@ -13,6 +13,7 @@ using QtNodes::FlowScene;
 using QtNodes::Node;
 using QtNodes::Connection;
 using QtNodes::NodeDataModel;
+using QtNodes::ConnectionCommand;
 
 
 NodeConnectionInteraction::
@@ -25,7 +26,7 @@ NodeConnectionInteraction(Node& node, Connection& connection, FlowScene& scene)
 
 bool
 NodeConnectionInteraction::
-canConnect(PortIndex &portIndex, bool& typeConversionNeeded, std::unique_ptr<NodeDataModel> & converterModel) const
+canConnect(PortIndex &portIndex, bool& typeConversionNeeded) const
 {
   typeConversionNeeded = false;
 
@@ -63,13 +64,14 @@ canConnect(PortIndex &portIndex, bool& typeConversionNeeded, std::unique_ptr<Nod
   auto const   &modelTarget = _node->nodeDataModel();
   NodeDataType candidateNodeDataType = modelTarget->dataType(requiredPort, portIndex);
 
-  if (connectionDataType.id != candidateNodeDataType.id)
+  // The converter model itself is only created once the connection is made
+  if (connectionDataType != candidateNodeDataType)
   {
     if (requiredPort == PortType::In)
     {
-      return typeConversionNeeded = (converterModel = _scene->registry().getTypeConverter(connectionDataType.id, candidateNodeDataType.id)) != nullptr;
+      return typeConversionNeeded = _scene->registry().hasTypeConverter(connectionDataType, candidateNodeDataType);
     }
-    return typeConversionNeeded = (converterModel = _scene->registry().getTypeConverter(candidateNodeDataType.id, connectionDataType.id)) != nullptr;
+    return typeConversionNeeded = _scene->registry().hasTypeConverter(candidateNodeDataType, connectionDataType);
   }
 
   return true;
@@ -83,9 +85,8 @@ tryConnect() const
   // 1) Check conditions from 'canConnect'
   PortIndex portIndex = INVALID;
   bool typeConversionNeeded = false; 
-  std::unique_ptr<NodeDataModel> typeConverterModel;
 
-  if (!canConnect(portIndex, typeConversionNeeded, typeConverterModel))
+  if (!canConnect(portIndex, typeConversionNeeded))
   {
     return false;
   }
@@ -101,6 +102,13 @@ tryConnect() const
     auto outNode = _connection->getNode(connectedPort);
     auto outNodePortIndex = _connection->getPortIndex(connectedPort);
 
+    NodeDataType const connectionDataType = _connection->dataType();
+    NodeDataType const nodeDataType = _node->nodeDataModel()->dataType(requiredPort, portIndex);
+
+    std::unique_ptr<NodeDataModel> typeConverterModel = (requiredPort == PortType::In)
+      ? _scene->registry().getTypeConverter(connectionDataType, nodeDataType)
+      : _scene->registry().getTypeConverter(nodeDataType, connectionDataType);
+
     //Creating the converter node
     Node& converterNode = _scene->createNode(std::move(typeConverterModel));
     
@@ -138,6 +146,8 @@ tryConnect() const
   // The port is not longer required after this function
   _connection->setNodeToPort(*_node, requiredPort, portIndex);
 
+  _scene->trackConnection(*_connection);
+
   // 4) Adjust Connection geometry
 
   _node->nodeGraphicsObject().moveConnections();
@@ -152,32 +162,12 @@ tryConnect() const
     outNode->onDataUpdatedConnection(outPortIndex, _connection);
   }
   
-  QUuid connectionID = _connection->id();
-  FlowScene *scene = _scene;
-  QUuid nodeInID = _connection->getNode(PortType::In)->id();
-  QUuid nodeOutID = _connection->getNode(PortType::Out)->id();
-  PortIndex portIn = _connection->getPortIndex(PortType::In);
-  PortIndex portOut = _connection->getPortIndex(PortType::Out);
-  _scene->AddAction(UndoRedoAction(
-    [scene, connectionID](void *ptr)
-    {
-      scene->deleteConnectionWithID(connectionID);
-      return 0;
-    },
-    [scene, nodeInID, portIn, nodeOutID, portOut, connectionID](void *ptr)
-    {
-      QUuid id = connectionID;
-      Node *nodeIn = scene->nodes()[nodeInID].get();
-      Node *nodeOut = scene->nodes()[nodeOutID].get();
-      scene->createConnection(*nodeIn,
-                              portIn,
-                              *nodeOut,
-                              portOut,
-                              &id);
-      return 0;
-    },
-    "Created Connection "
-  ));
+  _scene->pushCommand(std::make_unique<ConnectionCommand>(ConnectionCommand::Kind::Added,
+                                                          _connection->id(),
+                                                          _connection->getNode(PortType::In)->id(),
+                                                          _connection->getPortIndex(PortType::In),
+                                                          _connection->getNode(PortType::Out)->id(),
+                                                          _connection->getPortIndex(PortType::Out)));
 
   return true;
 }
@@ -192,9 +182,8 @@ disconnect(PortType portToDisconnect) const
 {
 
   QUuid connectionID = _connection->id();
-  FlowScene *scene = _scene;
-  Node *nodeIn = _connection->getNode(PortType::In);
-  Node *nodeOut = _connection->getNode(PortType::Out);
+  QUuid nodeInID = _connection->getNode(PortType::In)->id();
+  QUuid nodeOutID = _connection->getNode(PortType::Out)->id();
   PortIndex portIn = _connection->getPortIndex(PortType::In);
   PortIndex portOut = _connection->getPortIndex(PortType::Out);
 
@@ -206,6 +195,8 @@ disconnect(PortType portToDisconnect) const
   // clear pointer to Connection in the NodeState
   state.getEntries(portToDisconnect)[portIndex].clear();
 
+  _scene->untrackConnection(*_connection);
+
   // 4) Propagate invalid data to IN node
   _connection->propagateEmptyData();
 
@@ -216,24 +207,12 @@ disconnect(PortType portToDisconnect) const
 
   _connection->getConnectionGraphicsObject().grabMouse();
 
-  _scene->AddAction(UndoRedoAction(
-    [scene, nodeIn, portIn, nodeOut, portOut, connectionID](void *ptr)
-    {
-      QUuid id = connectionID;
-      scene->createConnection(*nodeIn,
-                              portIn,
-                              *nodeOut,
-                              portOut,
-                              &id);
-      return 0;
-    },
-    [scene, connectionID](void *ptr)
-    {
-      scene->deleteConnectionWithID(connectionID);
-      return 0;
-    },
-    "Removed Connection "
-  ));
+  _scene->pushCommand(std::make_unique<ConnectionCommand>(ConnectionCommand::Kind::Removed,
+                                                          connectionID,
+                                                          nodeInID,
+                                                          portIn,
+                                                          nodeOutID,
+                                                          portOut));
   
   return true;
 }
@@ -8,7 +8,6 @@ using QtNodes::NodeStyle;
 
 NodeDataModel::
 NodeDataModel()
-  : _nodeStyle(StyleCollection::nodeStyle())
 {
   // Derived classes can initialize specific style here
 }
@@ -30,7 +29,10 @@ NodeStyle const&
 NodeDataModel::
 nodeStyle() const
 {
-  return _nodeStyle;
+  if (_nodeStyle)
+    return *_nodeStyle;
+
+  return StyleCollection::nodeStyle();
 }
 
 
@@ -38,7 +40,15 @@ void
 NodeDataModel::
 setNodeStyle(NodeStyle const& style)
 {
-  _nodeStyle = style;
+  _nodeStyle = std::make_shared<NodeStyle const>(style);
+}
+
+
+void
+NodeDataModel::
+setNodeStyle(std::shared_ptr<NodeStyle const> style)
+{
+  _nodeStyle = std::move(style);
 }
 
 
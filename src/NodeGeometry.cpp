@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <cmath>
+#include <vector>
 
 #include "PortType.hpp"
 #include "NodeState.hpp"
@@ -12,6 +13,7 @@
 #include "StyleCollection.hpp"
 
 using QtNodes::NodeGeometry;
+using QtNodes::NodeFontMetrics;
 using QtNodes::NodeDataModel;
 using QtNodes::PortIndex;
 using QtNodes::PortType;
@@ -30,12 +32,39 @@ NodeGeometry(std::unique_ptr<NodeDataModel> const &dataModel)
   , _nSinks(dataModel->nPorts(PortType::In))
   , _draggingPos(-1000, -1000)
   , _dataModel(dataModel)
-  , _fontMetrics(QFont())
-  , _boldFontMetrics(QFont())
+  , _fontMetrics(NodeFontMetrics::forFont(QFont()))
+{}
+
+
+NodeFontMetrics::
+NodeFontMetrics(QFont const &font)
+  : font(font)
+  , metrics(font)
+  , boldMetrics(font)
 {
-  QFont f; f.setBold(true);
+  QFont boldFont = font;
+  boldFont.setBold(true);
+
+  boldMetrics = QFontMetrics(boldFont);
+}
+
+
+std::shared_ptr<NodeFontMetrics const>
+NodeFontMetrics::
+forFont(QFont const &font)
+{
+  // Only a handful of fonts are ever used to draw nodes
+  static std::vector<std::shared_ptr<NodeFontMetrics const>> cache;
+
+  for (auto const &fontMetrics : cache)
+  {
+    if (fontMetrics->font == font)
+      return fontMetrics;
+  }
+
+  cache.push_back(std::make_shared<NodeFontMetrics const>(font));
 
-  _boldFontMetrics = QFontMetrics(f);
+  return cache.back();
 }
 
 
@@ -80,7 +109,94 @@ void
 NodeGeometry::
 recalculateSize() const
 {
-  _entryHeight = _fontMetrics.height();
+  QFontMetrics const &metrics     = _fontMetrics->metrics;
+  QFontMetrics const &boldMetrics = _fontMetrics->boldMetrics;
+
+  _entryHeight = metrics.height();
+
+  // All the text of the node is measured here, painting reuses the results
+  if (_dataModel->captionVisible())
+    _captionRect = boldMetrics.boundingRect(_dataModel->caption());
+  else
+    _captionRect = QRect();
+
+  for (PortType portType : { PortType::In, PortType::Out })
+  {
+    auto &labels = _portLabels[static_cast<int>(portType)];
+
+    unsigned int const nPorts = _dataModel->nPorts(portType);
+
+    labels.resize(nPorts);
+
+    for (unsigned int i = 0; i < nPorts; ++i)
+      labels[i] = measurePortLabel(portType, i);
+  }
+
+  // The font may have changed, updateSize measures the message again
+  _validationMessage.clear();
+  _validationWidth         = 0;
+  _validationWrappedHeight = 0;
+
+  updateSize();
+}
+
+
+void
+NodeGeometry::
+insertPort(PortType portType, PortIndex index)
+{
+  auto &labels = _portLabels[static_cast<int>(portType)];
+
+  labels.insert(labels.begin() + index, measurePortLabel(portType, index));
+
+  recalculateInOut();
+  updateSize();
+}
+
+
+void
+NodeGeometry::
+removePort(PortType portType, PortIndex index)
+{
+  auto &labels = _portLabels[static_cast<int>(portType)];
+
+  labels.erase(labels.begin() + index);
+
+  recalculateInOut();
+  updateSize();
+}
+
+
+NodeGeometry::PortLabel
+NodeGeometry::
+measurePortLabel(PortType portType, PortIndex index) const
+{
+  PortLabel label;
+
+  if (_dataModel->portCaptionVisible(portType, index))
+    label.text = _dataModel->portCaption(portType, index);
+  else
+    label.text = _dataModel->dataType(portType, index).name;
+
+  label.rect  = _fontMetrics->metrics.boundingRect(label.text);
+  label.width = _fontMetrics->metrics.width(label.text);
+
+  return label;
+}
+
+
+void
+NodeGeometry::
+updateSize() const
+{
+  _inputPortWidth  = 0;
+  _outputPortWidth = 0;
+
+  for (PortLabel const &label : _portLabels[static_cast<int>(PortType::In)])
+    _inputPortWidth = std::max(unsigned(label.width), _inputPortWidth);
+
+  for (PortLabel const &label : _portLabels[static_cast<int>(PortType::Out)])
+    _outputPortWidth = std::max(unsigned(label.width), _outputPortWidth);
 
   {
     unsigned int maxNumOfEntries = std::max(_nSinks, _nSources);
@@ -95,9 +211,6 @@ recalculateSize() const
 
   _height += captionHeight();
 
-  _inputPortWidth  = portWidth(PortType::In);
-  _outputPortWidth = portWidth(PortType::Out);
-
   _width = _inputPortWidth +
            _outputPortWidth +
            2 * _spacing;
@@ -109,10 +222,27 @@ recalculateSize() const
 
   _width = std::max(_width, captionWidth());
 
+  _validationHeight = 0;
+
   if (_dataModel->validationState() != NodeValidationState::Valid)
   {
-    _width   = std::max(_width, validationWidth());
-    _height += validationHeight() + _spacing;
+    QString const message = _dataModel->validationMessage();
+
+    // Wrapping the message is the costly part, it is kept until the
+    // message or the width it is wrapped to changes
+    if (message != _validationMessage || _width != _validationWrapWidth)
+    {
+      _validationMessage   = message;
+      _validationWrapWidth = _width;
+      _validationWidth     = validationWidth();
+
+      _validationWrappedHeight = measureValidationHeight(std::max(_width, _validationWidth));
+    }
+
+    _width = std::max(_width, _validationWidth);
+
+    _validationHeight = _validationWrappedHeight;
+    _height += _validationHeight + _spacing;
   }
 }
 
@@ -121,17 +251,15 @@ void
 NodeGeometry::
 recalculateSize(QFont const & font) const
 {
-  QFontMetrics fontMetrics(font);
-  QFont boldFont = font;
-
-  boldFont.setBold(true);
+  // Called on every paint, the font hardly ever changes
+  if (_fontMetrics->font == font)
+    return;
 
-  QFontMetrics boldFontMetrics(boldFont);
+  auto fontMetrics = NodeFontMetrics::forFont(font);
 
-  if (_boldFontMetrics != boldFontMetrics)
+  if (_fontMetrics != fontMetrics)
   {
-    _fontMetrics     = fontMetrics;
-    _boldFontMetrics = boldFontMetrics;
+    _fontMetrics = std::move(fontMetrics);
 
     recalculateSize();
   }
@@ -193,30 +321,30 @@ checkHitScenePoint(PortType portType,
 {
   auto const &nodeStyle = StyleCollection::nodeStyle();
 
-  PortIndex result = INVALID;
-
   if (portType == PortType::None)
-    return result;
+    return INVALID;
 
-  double const tolerance = 2.0 * nodeStyle.ConnectionPointDiameter;
+  int const nItems = static_cast<int>(_dataModel->nPorts(portType));
 
-  size_t const nItems = _dataModel->nPorts(portType);
+  if (nItems == 0)
+    return INVALID;
 
-  for (size_t i = 0; i < nItems; ++i)
-  {
-    auto pp = portScenePosition(i, portType, sceneTransform);
+  QPointF const point = sceneTransform.inverted().map(scenePoint);
 
-    QPointF p = pp - scenePoint;
-    auto    distance = std::sqrt(QPointF::dotProduct(p, p));
+  // Ports sit on a fixed vertical step, only the nearest one can be hit
+  double const step   = _entryHeight + _spacing;
+  double const firstY = captionHeight() + step / 2.0;
 
-    if (distance < tolerance)
-    {
-      result = PortIndex(i);
-      break;
-    }
-  }
+  int const index = qBound(0, qRound((point.y() - firstY) / step), nItems - 1);
+
+  QPointF const diff = portScenePosition(index, portType) - point;
+
+  double const tolerance = 2.0 * nodeStyle.ConnectionPointDiameter;
+
+  if (QPointF::dotProduct(diff, diff) < tolerance * tolerance)
+    return PortIndex(index);
 
-  return result;
+  return INVALID;
 }
 
 
@@ -241,11 +369,11 @@ widgetPosition() const
   {
     if (_dataModel->validationState() != NodeValidationState::Valid)
     {
-      return QPointF(_spacing + portWidth(PortType::In),
+      return QPointF(_spacing + _inputPortWidth,
                      (captionHeight() + _height - validationHeight() - _spacing - w->height()) / 2.0);
     }
 
-    return QPointF(_spacing + portWidth(PortType::In),
+    return QPointF(_spacing + _inputPortWidth,
                    (captionHeight() + _height - w->height()) / 2.0);
   }
 
@@ -253,35 +381,37 @@ widgetPosition() const
 }
 
 
-unsigned int
+QString const &
 NodeGeometry::
-captionHeight() const
+portLabel(PortType portType, PortIndex index) const
 {
-  if (!_dataModel->captionVisible())
-    return 0;
+  static QString const none;
 
-  QString name = _dataModel->caption();
+  auto const &labels = _portLabels[static_cast<int>(portType)];
 
-  return _boldFontMetrics.boundingRect(name).height();
+  if (index < 0 || static_cast<std::size_t>(index) >= labels.size())
+    return none;
+
+  return labels[index].text;
 }
 
 
-unsigned int
+QRect
 NodeGeometry::
-captionWidth() const
+portLabelRect(PortType portType, PortIndex index) const
 {
-  if (!_dataModel->captionVisible())
-    return 0;
+  auto const &labels = _portLabels[static_cast<int>(portType)];
 
-  QString name = _dataModel->caption();
+  if (index < 0 || static_cast<std::size_t>(index) >= labels.size())
+    return QRect();
 
-  return _boldFontMetrics.boundingRect(name).width();
+  return labels[index].rect;
 }
 
 
 unsigned int
 NodeGeometry::
-validationHeight() const
+measureValidationHeight(unsigned int width) const
 {
   QString msg = _dataModel->validationMessage();
 
@@ -291,14 +421,14 @@ validationHeight() const
   // Calculate height for multi-line text with word wrapping
   // Use the node width minus padding for text wrapping
   double padding = 8.0; // 4.0 padding on each side
-  int availableWidth = _width - static_cast<int>(padding);
+  int availableWidth = width - static_cast<int>(padding);
   
   // Ensure we have a minimum width for the calculation
   if (availableWidth < 50)
     availableWidth = 50;
 
   // Use boundingRect with width constraint to get the actual height needed for wrapped text
-  QRect boundingRect = _boldFontMetrics.boundingRect(0, 0, availableWidth, 0,
+  QRect boundingRect = _fontMetrics->boldMetrics.boundingRect(0, 0, availableWidth, 0,
                                                      Qt::AlignCenter | Qt::TextWordWrap,
                                                      msg);
   
@@ -324,7 +454,7 @@ validationWidth() const
   // Ensure we have a minimum width for the calculation
   if (availableWidth < 50)
     availableWidth = 50;
-  QRect boundingRect = _boldFontMetrics.boundingRect(0, 0, availableWidth, 0,
+  QRect boundingRect = _fontMetrics->boldMetrics.boundingRect(0, 0, availableWidth, 0,
                                                      Qt::AlignCenter | Qt::TextWordWrap,
                                                      msg);
   int singleLineWidth = boundingRect.width();
@@ -354,30 +484,3 @@ calculateNodePositionBetweenNodePorts(PortIndex targetPortIndex, PortType target
   converterNodePos.setY(converterNodePos.y() - newNode.nodeGeometry().height() / 2.0f);
   return converterNodePos;
 }
-
-
-unsigned int
-NodeGeometry::
-portWidth(PortType portType) const
-{
-  unsigned width = 0;
-
-  for (auto i = 0ul; i < _dataModel->nPorts(portType); ++i)
-  {
-    QString name;
-
-    if (_dataModel->portCaptionVisible(portType, i))
-    {
-      name = _dataModel->portCaption(portType, i);
-    }
-    else
-    {
-      name = _dataModel->dataType(portType, i).name;
-    }
-
-    width = std::max(unsigned(_fontMetrics.width(name)),
-                     width);
-  }
-
-  return width;
-}
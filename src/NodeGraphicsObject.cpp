@@ -76,7 +76,9 @@ NodeGraphicsObject(FlowScene &scene,
 NodeGraphicsObject::
 ~NodeGraphicsObject()
 {
-  _scene.removeItem(this);
+  // Children of a group item leave the scene together with it
+  if (scene())
+    _scene.removeItem(this);
 }
 
 
@@ -170,6 +172,14 @@ moveConnections() const
   moveConnections(PortType::Out);
 }
 
+
+void
+NodeGraphicsObject::
+scheduleMoveConnections() const
+{
+  _scene.scheduleConnectionUpdate(_node);
+}
+
 void NodeGraphicsObject::lock(bool locked)
 {
   _locked = locked;
@@ -212,9 +222,15 @@ NodeGraphicsObject::
 itemChange(GraphicsItemChange change, const QVariant &value)
 {
   
+  // Also sent when a parent group moves
+  if (change == ItemScenePositionHasChanged && scene())
+  {
+    scheduleMoveConnections();
+    _scene.expandSceneRect(sceneBoundingRect());
+  }
+
   if (change == ItemPositionChange && scene())
   {
-    moveConnections();
     QPointF newPos = value.toPointF();
     if(_scene.snapping)
     {
@@ -248,6 +264,8 @@ mousePressEvent(QGraphicsSceneMouseEvent * event)
     _scene.clearSelection();
   }
 
+  _scene.beginMoveGesture(this);
+
   _scene.nodeClicked(node());
 
   auto clickPort =
@@ -264,7 +282,7 @@ mousePressEvent(QGraphicsSceneMouseEvent * event)
       {
         NodeState const & nodeState = _node.nodeState();
 
-        std::unordered_map<QUuid, Connection*> connections =
+        NodeState::ConnectionPtrSet connections =
           nodeState.connections(portToCheck, portIndex);
 
         // start dragging existing connection
@@ -354,27 +372,18 @@ mouseMoveEvent(QGraphicsSceneMouseEvent * event)
       update();
 
       moveConnections();
+      _scene.expandSceneRect(sceneBoundingRect());
 
       event->accept();
     }
   }
   else
   {
+    // Connections follow through itemChange, once per frame
     QGraphicsObject::mouseMoveEvent(event);
 
-    if (event->lastPos() != event->pos())
-      moveConnections();
-
     event->ignore();
-	
-	
   }
-
-  QRectF r = scene()->sceneRect();
-
-  r = r.united(mapToScene(boundingRect()).boundingRect());
-
-  scene()->setSceneRect(r);
 }
 
 
@@ -389,9 +398,10 @@ mouseReleaseEvent(QGraphicsSceneMouseEvent* event)
   QGraphicsObject::mouseReleaseEvent(event);
   
   _scene.nodeMoveFinished(_node, pos(), oldPosition);
+  _scene.endMoveGesture();
 
   // position connections precisely after fast node move
-  moveConnections();
+  _scene.flushConnectionUpdates();
 }
 
 
@@ -147,15 +147,15 @@ drawConnectionPoints(QPainter* painter,
           {
             if (portType == PortType::In)
             {
-              typeConvertable = scene.registry().getTypeConverter(state.reactingDataType().id, dataType.id) != nullptr;
+              typeConvertable = scene.registry().hasTypeConverter(state.reactingDataType(), dataType);
             }
             else
             {
-              typeConvertable = scene.registry().getTypeConverter(dataType.id, state.reactingDataType().id) != nullptr;
+              typeConvertable = scene.registry().hasTypeConverter(dataType, state.reactingDataType());
             }
           }
 
-          if (state.reactingDataType().id == dataType.id || typeConvertable)
+          if (state.reactingDataType() == dataType || typeConvertable)
           {
             double const thres = 40.0;
             r = (dist < thres) ?
@@ -173,7 +173,7 @@ drawConnectionPoints(QPainter* painter,
 
         if (connectionStyle.useDataDefinedColors())
         {
-          painter->setBrush(connectionStyle.normalColor(dataType.id));
+          painter->setBrush(connectionStyle.normalColor(dataType));
         }
         else
         {
@@ -218,7 +218,7 @@ drawFilledConnectionPoints(QPainter * painter,
 
           if (connectionStyle.useDataDefinedColors())
           {
-            QColor const c = connectionStyle.normalColor(dataType.id);
+            QColor const c = connectionStyle.normalColor(dataType);
             painter->setPen(c);
             painter->setBrush(c);
           }
@@ -260,9 +260,7 @@ drawModelName(QPainter * painter,
 
   f.setBold(true);
 
-  QFontMetrics metrics(f);
-
-  auto rect = metrics.boundingRect(name);
+  QRect const &rect = geom.captionRect();
 
   QPointF position((geom.width() - rect.width()) / 2.0,
                    (geom.spacing() + geom.entryHeight()) / 3.0);
@@ -284,9 +282,6 @@ drawEntryLabels(QPainter * painter,
                 NodeDataModel const * model, 
                 std::vector<bool> &inputSelected)
 {
-  QFontMetrics const & metrics =
-    painter->fontMetrics();
-
   auto drawPoints =
     [&](PortType portType, std::vector<bool> *inputSelected=nullptr)
     {
@@ -308,18 +303,9 @@ drawEntryLabels(QPainter * painter,
         if(inputSelected != nullptr && inputSelected->at(i)) 
           painter->setPen(nodeStyle.FontColorSelected);
 
-        QString s;
+        QString const &s = geom.portLabel(portType, i);
 
-        if (model->portCaptionVisible(portType, i))
-        {
-          s = model->portCaption(portType, i);
-        }
-        else
-        {
-          s = model->dataType(portType, i).name;
-        }
-
-        auto rect = metrics.boundingRect(s);
+        QRect const rect = geom.portLabelRect(portType, i);
 
         p.setY(p.y() + rect.height() / 4.0);
 
@@ -418,8 +404,6 @@ drawValidationRect(QPainter * painter,
 
     QFont f = painter->font();
 
-    QFontMetrics metrics(f);
-
     // Calculate the available area for text with some padding
     double padding = 4.0;
     QRectF textRect(padding,
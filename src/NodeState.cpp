@@ -110,6 +110,40 @@ eraseInputAtIndex(PortIndex portIndex)
   
 }
 
+
+void
+NodeState::
+insertPort(PortType portType, PortIndex portIndex)
+{
+  auto &entries = getEntries(portType);
+
+  entries.insert(entries.begin() + portIndex, ConnectionPtrSet());
+
+  for (std::size_t i = portIndex + 1; i < entries.size(); ++i)
+  {
+    for (auto &pair : entries[i])
+      pair.second->setPortIndex(portType, static_cast<PortIndex>(i));
+  }
+}
+
+
+void
+NodeState::
+removePort(PortType portType, PortIndex portIndex)
+{
+  auto &entries = getEntries(portType);
+
+  Q_ASSERT(entries[portIndex].empty());
+
+  entries.erase(entries.begin() + portIndex);
+
+  for (std::size_t i = portIndex; i < entries.size(); ++i)
+  {
+    for (auto &pair : entries[i])
+      pair.second->setPortIndex(portType, static_cast<PortIndex>(i));
+  }
+}
+
 NodeState::ReactToConnectionState
 NodeState::
 reaction() const
@@ -0,0 +1,215 @@
+#include "PropagationTrace.hpp"
+
+#include <unordered_map>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QThread>
+
+#include "Node.hpp"
+#include "NodeDataModel.hpp"
+
+using QtNodes::PropagationTrace;
+using QtNodes::Node;
+using QtNodes::PortIndex;
+
+namespace
+{
+
+quint64
+currentThreadKey()
+{
+  return static_cast<quint64>(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+}
+
+}
+
+
+PropagationTrace::Scope::
+Scope(PropagationTrace &trace,
+      Node const &node,
+      PortIndex portIndex,
+      bool emptyData)
+  : _trace(trace)
+  , _node(node)
+  , _portIndex(portIndex)
+  , _emptyData(emptyData)
+  , _active(trace.isRecording())
+  , _startUs(_active ? trace.now() : 0)
+{}
+
+
+PropagationTrace::Scope::
+~Scope()
+{
+  if (!_active)
+    return;
+
+  Event event;
+  event.nodeId    = _node.id();
+  event.modelName = _node.nodeDataModel()->name();
+  event.portIndex = _portIndex;
+  event.emptyData = _emptyData;
+  event.startUs   = _startUs;
+  event.endUs     = _trace.now();
+  event.threadId  = currentThreadKey();
+  event.guiThread = QCoreApplication::instance() &&
+                    QThread::currentThread() == QCoreApplication::instance()->thread();
+
+  _trace.addEvent(event);
+}
+
+
+PropagationTrace::
+PropagationTrace()
+  : _recording(false)
+  , _epochNs(0)
+{
+  _clock.start();
+}
+
+
+void
+PropagationTrace::
+start()
+{
+  _recording = true;
+}
+
+
+void
+PropagationTrace::
+stop()
+{
+  _recording = false;
+}
+
+
+void
+PropagationTrace::
+clear()
+{
+  QMutexLocker locker(&_mutex);
+
+  _events.clear();
+  _epochNs = _clock.nsecsElapsed();
+}
+
+
+std::vector<PropagationTrace::Event>
+PropagationTrace::
+events() const
+{
+  QMutexLocker locker(&_mutex);
+
+  return _events;
+}
+
+
+qint64
+PropagationTrace::
+now() const
+{
+  return (_clock.nsecsElapsed() - _epochNs) / 1000;
+}
+
+
+void
+PropagationTrace::
+addEvent(Event const &event)
+{
+  QMutexLocker locker(&_mutex);
+
+  _events.push_back(event);
+}
+
+
+QJsonObject
+PropagationTrace::
+toChromeTrace() const
+{
+  std::vector<Event> const recorded = events();
+
+  qint64 const pid = QCoreApplication::applicationPid();
+
+  // Chrome expects small integer thread ids, native handles are remapped
+  std::unordered_map<quint64, int> threadIndices;
+  std::unordered_map<int, bool>    guiThreads;
+
+  auto threadIndex = [&](quint64 key)
+    {
+      auto it = threadIndices.find(key);
+
+      if (it != threadIndices.end())
+        return it->second;
+
+      int index = static_cast<int>(threadIndices.size()) + 1;
+      threadIndices[key] = index;
+      return index;
+    };
+
+  QJsonArray traceEvents;
+
+  for (auto const &e : recorded)
+  {
+    QJsonObject args;
+    args["node"]  = e.nodeId.toString();
+    args["port"]  = e.portIndex;
+    args["empty"] = e.emptyData;
+
+    QJsonObject traceEvent;
+    traceEvent["name"] = e.modelName;
+    traceEvent["cat"]  = QStringLiteral("propagation");
+    traceEvent["ph"]   = QStringLiteral("X");
+    traceEvent["ts"]   = static_cast<double>(e.startUs);
+    traceEvent["dur"]  = static_cast<double>(e.endUs - e.startUs);
+    traceEvent["pid"]  = static_cast<double>(pid);
+    traceEvent["tid"]  = threadIndex(e.threadId);
+    traceEvent["args"] = args;
+
+    guiThreads[threadIndex(e.threadId)] = e.guiThread;
+
+    traceEvents.append(traceEvent);
+  }
+
+  for (auto const &pair : threadIndices)
+  {
+    QJsonObject args;
+    args["name"] = guiThreads[pair.second] ?
+                   QStringLiteral("GUI thread") :
+                   QStringLiteral("Worker thread %1").arg(pair.second);
+
+    QJsonObject metadata;
+    metadata["name"] = QStringLiteral("thread_name");
+    metadata["ph"]   = QStringLiteral("M");
+    metadata["pid"]  = static_cast<double>(pid);
+    metadata["tid"]  = pair.second;
+    metadata["args"] = args;
+
+    traceEvents.append(metadata);
+  }
+
+  QJsonObject trace;
+  trace["traceEvents"]     = traceEvents;
+  trace["displayTimeUnit"] = QStringLiteral("ms");
+
+  return trace;
+}
+
+
+bool
+PropagationTrace::
+saveChromeTrace(QString const &fileName) const
+{
+  QFile file(fileName);
+
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+
+  file.write(QJsonDocument(toChromeTrace()).toJson(QJsonDocument::Compact));
+
+  return true;
+}
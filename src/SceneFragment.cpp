@@ -0,0 +1,114 @@
+#include "SceneFragment.hpp"
+
+#include <unordered_map>
+
+#include <QtCore/QUuid>
+
+#include "DataModelRegistry.hpp"
+#include "QUuidStdHash.hpp"
+
+using QtNodes::SceneFragment;
+using QtNodes::DataModelRegistry;
+using QtNodes::NodeDataModel;
+using QtNodes::PortIndex;
+
+std::shared_ptr<SceneFragment>
+SceneFragment::
+fromJson(QJsonObject const &json, DataModelRegistry &registry)
+{
+  auto fragment = std::make_shared<SceneFragment>();
+
+  QJsonArray const nodesJsonArray = json["nodes"].toArray();
+
+  fragment->models.reserve(nodesJsonArray.size());
+  fragment->positions.reserve(nodesJsonArray.size());
+
+  // Index of every kept node in the fragment
+  std::unordered_map<QUuid, int> indices;
+
+  for (auto const &nodeValue : nodesJsonArray)
+  {
+    QJsonObject const nodeJson  = nodeValue.toObject();
+    QJsonObject const modelJson = nodeJson["model"].toObject();
+
+    std::unique_ptr<NodeDataModel> model = registry.create(modelJson["name"].toString());
+    if (!model)
+      continue;
+
+    model->restore(modelJson);
+
+    QJsonObject const positionJson = nodeJson["position"].toObject();
+
+    indices[QUuid(nodeJson["id"].toString())] = static_cast<int>(fragment->models.size());
+    fragment->models.push_back(std::move(model));
+    fragment->positions.emplace_back(positionJson["x"].toDouble(),
+                                     positionJson["y"].toDouble());
+  }
+
+  for (auto const &connectionValue : json["connections"].toArray())
+  {
+    QJsonObject const connectionJson = connectionValue.toObject();
+
+    auto in  = indices.find(QUuid(connectionJson["in_id"].toString()));
+    auto out = indices.find(QUuid(connectionJson["out_id"].toString()));
+
+    if (in == indices.end() || out == indices.end())
+      continue;
+
+    fragment->connections.push_back({ out->second,
+                                      static_cast<PortIndex>(connectionJson["out_index"].toInt()),
+                                      in->second,
+                                      static_cast<PortIndex>(connectionJson["in_index"].toInt()) });
+  }
+
+  fragment->groups = json["groups"].toArray();
+
+  return fragment;
+}
+
+
+QJsonObject
+SceneFragment::
+toJson() const
+{
+  std::vector<QString> ids;
+  ids.reserve(models.size());
+
+  QJsonArray nodesJsonArray;
+
+  for (std::size_t i = 0; i < models.size(); ++i)
+  {
+    ids.push_back(QUuid::createUuid().toString());
+
+    QJsonObject positionJson;
+    positionJson["x"] = positions[i].x();
+    positionJson["y"] = positions[i].y();
+
+    QJsonObject nodeJson;
+    nodeJson["id"]       = ids.back();
+    nodeJson["model"]    = models[i]->save();
+    nodeJson["position"] = positionJson;
+
+    nodesJsonArray.append(nodeJson);
+  }
+
+  QJsonArray connectionsJsonArray;
+
+  for (ConnectionEntry const &entry : connections)
+  {
+    QJsonObject connectionJson;
+    connectionJson["in_id"]     = ids[entry.inNode];
+    connectionJson["in_index"]  = entry.inPort;
+    connectionJson["out_id"]    = ids[entry.outNode];
+    connectionJson["out_index"] = entry.outPort;
+
+    connectionsJsonArray.append(connectionJson);
+  }
+
+  QJsonObject json;
+  json["nodes"]       = nodesJsonArray;
+  json["connections"] = connectionsJsonArray;
+  json["groups"]      = groups;
+
+  return json;
+}
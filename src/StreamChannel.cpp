@@ -0,0 +1,219 @@
+#include "StreamChannel.hpp"
+
+#include <algorithm>
+
+using QtNodes::StreamChannel;
+using QtNodes::StreamReader;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+
+StreamChannel::
+StreamChannel(NodeDataType chunkType, std::size_t capacity)
+  : _chunkType(std::move(chunkType))
+  , _capacity(std::max<std::size_t>(capacity, 1))
+{}
+
+
+StreamChannel::
+~StreamChannel()
+{
+  // Readers keep the channel alive, none is left by now
+  Q_ASSERT(_readers.empty());
+}
+
+
+std::size_t
+StreamChannel::
+size() const
+{
+  QMutexLocker locker(&_mutex);
+
+  return _chunks.size();
+}
+
+
+bool
+StreamChannel::
+tryPush(std::shared_ptr<NodeData> chunk)
+{
+  {
+    QMutexLocker locker(&_mutex);
+
+    if (_closed || _chunks.size() >= _capacity)
+      return false;
+
+    _chunks.push_back(std::move(chunk));
+  }
+
+  emit chunkPushed();
+
+  return true;
+}
+
+
+bool
+StreamChannel::
+push(std::shared_ptr<NodeData> chunk)
+{
+  {
+    QMutexLocker locker(&_mutex);
+
+    while (!_closed && _chunks.size() >= _capacity)
+      _notFull.wait(&_mutex);
+
+    if (_closed)
+      return false;
+
+    _chunks.push_back(std::move(chunk));
+  }
+
+  emit chunkPushed();
+
+  return true;
+}
+
+
+void
+StreamChannel::
+close()
+{
+  {
+    QMutexLocker locker(&_mutex);
+
+    if (_closed)
+      return;
+
+    _closed = true;
+  }
+
+  // A producer blocked in push gives up
+  _notFull.wakeAll();
+
+  emit closed();
+}
+
+
+bool
+StreamChannel::
+isClosed() const
+{
+  QMutexLocker locker(&_mutex);
+
+  return _closed;
+}
+
+
+bool
+StreamChannel::
+trim()
+{
+  // Without readers the chunks wait for the first one
+  if (_readers.empty())
+    return false;
+
+  quint64 slowest = _readers.front()->_position;
+  for (StreamReader const *reader : _readers)
+    slowest = std::min(slowest, reader->_position);
+
+  bool const wasFull = _chunks.size() >= _capacity;
+
+  while (_firstPosition < slowest)
+  {
+    _chunks.pop_front();
+    ++_firstPosition;
+  }
+
+  if (!wasFull || _chunks.size() >= _capacity)
+    return false;
+
+  _notFull.wakeAll();
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+StreamReader::
+StreamReader(std::shared_ptr<StreamChannel> channel)
+  : _channel(std::move(channel))
+{
+  QMutexLocker locker(&_channel->_mutex);
+
+  _position = _channel->_firstPosition;
+  _channel->_readers.push_back(this);
+}
+
+
+StreamReader::
+~StreamReader()
+{
+  bool freed     = false;
+  bool abandoned = false;
+
+  {
+    QMutexLocker locker(&_channel->_mutex);
+
+    auto &readers = _channel->_readers;
+    readers.erase(std::find(readers.begin(), readers.end(), this));
+
+    if (readers.empty() && !_channel->_closed)
+    {
+      // Nobody listens anymore, the producer can stop
+      _channel->_closed = true;
+      _channel->_chunks.clear();
+      abandoned = true;
+    }
+    else
+    {
+      freed = _channel->trim();
+    }
+  }
+
+  if (abandoned)
+  {
+    _channel->_notFull.wakeAll();
+    emit _channel->closed();
+  }
+  else if (freed)
+  {
+    emit _channel->spaceAvailable();
+  }
+}
+
+
+std::shared_ptr<NodeData>
+StreamReader::
+read()
+{
+  std::shared_ptr<NodeData> chunk;
+  bool freed;
+
+  {
+    QMutexLocker locker(&_channel->_mutex);
+
+    quint64 const end = _channel->_firstPosition + _channel->_chunks.size();
+    if (_position == end)
+      return nullptr;
+
+    chunk = _channel->_chunks[_position - _channel->_firstPosition];
+    ++_position;
+
+    freed = _channel->trim();
+  }
+
+  if (freed)
+    emit _channel->spaceAvailable();
+
+  return chunk;
+}
+
+
+bool
+StreamReader::
+atEnd() const
+{
+  QMutexLocker locker(&_channel->_mutex);
+
+  return _channel->_closed &&
+         _position == _channel->_firstPosition + _channel->_chunks.size();
+}
@@ -0,0 +1,80 @@
+#include "TypeRegistry.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+#include <QtCore/QReadWriteLock>
+
+#include "QStringStdHash.hpp"
+
+using QtNodes::TypeRegistry;
+using QtNodes::TypeHandle;
+
+namespace
+{
+
+struct TypeTable
+{
+  QReadWriteLock lock;
+
+  std::unordered_map<QString, TypeHandle> handles;
+
+  // Indexed by handle, the empty id sits at 0
+  std::vector<QString> ids{ QString() };
+};
+
+
+TypeTable &
+typeTable()
+{
+  static TypeTable table;
+  return table;
+}
+}
+
+TypeHandle
+TypeRegistry::
+intern(QString const &typeId)
+{
+  if (typeId.isEmpty())
+    return 0;
+
+  TypeTable &table = typeTable();
+
+  {
+    QReadLocker locker(&table.lock);
+
+    auto it = table.handles.find(typeId);
+    if (it != table.handles.end())
+      return it->second;
+  }
+
+  QWriteLocker locker(&table.lock);
+
+  // Another thread may have interned it in between
+  auto it = table.handles.find(typeId);
+  if (it != table.handles.end())
+    return it->second;
+
+  TypeHandle const handle = static_cast<TypeHandle>(table.ids.size());
+
+  table.ids.push_back(typeId);
+  table.handles.emplace(typeId, handle);
+
+  return handle;
+}
+
+
+QString
+TypeRegistry::
+typeId(TypeHandle handle)
+{
+  TypeTable &table = typeTable();
+
+  QReadLocker locker(&table.lock);
+
+  if (handle >= table.ids.size())
+    return QString();
+
+  return table.ids[handle];
+}
@@ -0,0 +1,453 @@
+#include "UndoCommands.hpp"
+
+#include <utility>
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+
+#include "FlowScene.hpp"
+#include "Node.hpp"
+#include "Group.hpp"
+#include "NodeGraphicsObject.hpp"
+#include "GroupGraphicsObject.hpp"
+#include "SceneFragment.hpp"
+
+using QtNodes::UndoCommand;
+using QtNodes::ActionCommand;
+using QtNodes::MoveCommand;
+using QtNodes::SceneDiffCommand;
+using QtNodes::FragmentCommand;
+using QtNodes::ConnectionCommand;
+using QtNodes::UndoRedoAction;
+using QtNodes::FlowScene;
+using QtNodes::Node;
+using QtNodes::PortIndex;
+
+namespace
+{
+
+std::size_t
+stringUsage(QString const &string)
+{
+  return static_cast<std::size_t>(string.capacity()) * sizeof(QChar);
+}
+
+}
+
+
+bool
+UndoCommand::
+mergeWith(UndoCommand const &)
+{
+  return false;
+}
+
+//------------------------------------------------------------------------------
+
+ActionCommand::
+ActionCommand(UndoRedoAction action)
+  : _action(std::move(action))
+{}
+
+
+void
+ActionCommand::
+undo(FlowScene &)
+{
+  _action.undoAction(0);
+}
+
+
+void
+ActionCommand::
+redo(FlowScene &)
+{
+  _action.redoAction(0);
+}
+
+
+QString
+ActionCommand::
+name() const
+{
+  return _action.name;
+}
+
+
+std::size_t
+ActionCommand::
+memoryUsage() const
+{
+  return sizeof(*this) + stringUsage(_action.name);
+}
+
+//------------------------------------------------------------------------------
+
+MoveCommand::
+MoveCommand(std::vector<QUuid> groupIds,
+            std::vector<QUuid> nodeIds,
+            std::vector<qreal> positions,
+            QString name,
+            quint64 gesture)
+  : _groupIds(std::move(groupIds))
+  , _nodeIds(std::move(nodeIds))
+  , _positions(std::move(positions))
+  , _name(std::move(name))
+  , _gesture(gesture)
+{}
+
+
+void
+MoveCommand::
+undo(FlowScene &scene)
+{
+  apply(scene, false);
+}
+
+
+void
+MoveCommand::
+redo(FlowScene &scene)
+{
+  apply(scene, true);
+}
+
+
+QString
+MoveCommand::
+name() const
+{
+  return _name;
+}
+
+
+std::size_t
+MoveCommand::
+memoryUsage() const
+{
+  return sizeof(*this) +
+         (_groupIds.capacity() + _nodeIds.capacity()) * sizeof(QUuid) +
+         _positions.capacity() * sizeof(qreal) +
+         stringUsage(_name);
+}
+
+
+bool
+MoveCommand::
+mergeWith(UndoCommand const &next)
+{
+  auto move = dynamic_cast<MoveCommand const*>(&next);
+
+  if (!move ||
+      move->_gesture != _gesture ||
+      move->_groupIds != _groupIds ||
+      move->_nodeIds != _nodeIds)
+    return false;
+
+  // Keep where the items started, take where they ended
+  for (std::size_t i = 0; i < _positions.size(); i += 4)
+  {
+    _positions[i + 2] = move->_positions[i + 2];
+    _positions[i + 3] = move->_positions[i + 3];
+  }
+
+  return true;
+}
+
+
+void
+MoveCommand::
+apply(FlowScene &scene, bool useNewPositions) const
+{
+  std::size_t const offset = useNewPositions ? 2 : 0;
+
+  // Items may have been reparented into groups since, positions are
+  // mapped into their current parent
+  auto setScenePos = [](QGraphicsItem &item, QPointF const &scenePos)
+    {
+      if (item.parentItem())
+        item.setPos(item.parentItem()->mapFromScene(scenePos));
+      else
+        item.setPos(scenePos);
+    };
+
+  // Groups go first, so that nodes inside them end up at their own position
+  for (std::size_t i = 0; i < _groupIds.size(); ++i)
+  {
+    auto it = scene.groups().find(_groupIds[i]);
+    if (it == scene.groups().end())
+      continue;
+
+    std::size_t const p = 4 * i + offset;
+    setScenePos(it->second->groupGraphicsObject(),
+                QPointF(_positions[p], _positions[p + 1]));
+  }
+
+  for (std::size_t i = 0; i < _nodeIds.size(); ++i)
+  {
+    auto it = scene.nodes().find(_nodeIds[i]);
+    if (it == scene.nodes().end())
+      continue;
+
+    std::size_t const p = 4 * (_groupIds.size() + i) + offset;
+    setScenePos(it->second->nodeGraphicsObject(),
+                QPointF(_positions[p], _positions[p + 1]));
+  }
+}
+
+//------------------------------------------------------------------------------
+
+SceneDiffCommand::
+SceneDiffCommand(Kind kind, QJsonObject const &elements, QString name)
+  : _kind(kind)
+  , _blob(qCompress(QJsonDocument(elements).toJson(QJsonDocument::Compact)))
+  , _name(std::move(name))
+{
+  QJsonArray const nodesJsonArray = elements["nodes"].toArray();
+
+  _nodeIds.reserve(nodesJsonArray.size());
+
+  for (auto const &nodeJson : nodesJsonArray)
+    _nodeIds.push_back(QUuid(nodeJson.toObject()["id"].toString()));
+
+  QJsonArray const groupsJsonArray = elements["groups"].toArray();
+
+  _groupIds.reserve(groupsJsonArray.size());
+
+  for (auto const &groupJson : groupsJsonArray)
+  {
+    // Groups saved before they had an id cannot be found again
+    QUuid const id(groupJson.toObject()["id"].toString());
+    if (!id.isNull())
+      _groupIds.push_back(id);
+  }
+}
+
+
+void
+SceneDiffCommand::
+undo(FlowScene &scene)
+{
+  if (_kind == Kind::Added)
+    removeElements(scene);
+  else
+    insertElements(scene);
+}
+
+
+void
+SceneDiffCommand::
+redo(FlowScene &scene)
+{
+  if (_kind == Kind::Added)
+    insertElements(scene);
+  else
+    removeElements(scene);
+}
+
+
+QString
+SceneDiffCommand::
+name() const
+{
+  return _name;
+}
+
+
+std::size_t
+SceneDiffCommand::
+memoryUsage() const
+{
+  return sizeof(*this) +
+         static_cast<std::size_t>(_blob.capacity()) +
+         (_nodeIds.capacity() + _groupIds.capacity()) * sizeof(QUuid) +
+         stringUsage(_name);
+}
+
+
+QJsonObject
+SceneDiffCommand::
+elements() const
+{
+  return QJsonDocument::fromJson(qUncompress(_blob)).object();
+}
+
+
+void
+SceneDiffCommand::
+insertElements(FlowScene &scene) const
+{
+  scene.suspendPropagation();
+  scene.jsonToScene(elements());
+  scene.resumePropagation();
+}
+
+
+void
+SceneDiffCommand::
+removeElements(FlowScene &scene) const
+{
+  scene.suspendPropagation();
+
+  // jsonToScene restores the groups too, they would pile up otherwise
+  for (QUuid const &id : _groupIds)
+  {
+    auto it = scene.groups().find(id);
+    if (it != scene.groups().end())
+      scene.removeGroup(*it->second);
+  }
+
+  for (QUuid const &id : _nodeIds)
+  {
+    if (scene.nodes().count(id))
+      scene.removeNodeWithID(id);
+  }
+
+  scene.resumePropagation();
+}
+
+//------------------------------------------------------------------------------
+
+FragmentCommand::
+FragmentCommand(std::shared_ptr<SceneFragment const> fragment,
+                QPointF offset,
+                std::vector<QUuid> nodeIds,
+                std::vector<QUuid> groupIds,
+                QString name)
+  : _fragment(std::move(fragment))
+  , _offset(offset)
+  , _nodeIds(std::move(nodeIds))
+  , _groupIds(std::move(groupIds))
+  , _name(std::move(name))
+{}
+
+
+void
+FragmentCommand::
+undo(FlowScene &scene)
+{
+  scene.suspendPropagation();
+
+  for (QUuid const &id : _groupIds)
+  {
+    auto it = scene.groups().find(id);
+    if (it != scene.groups().end())
+      scene.removeGroup(*it->second);
+  }
+
+  for (QUuid const &id : _nodeIds)
+    scene.removeNodeWithID(id);
+
+  scene.resumePropagation();
+}
+
+
+void
+FragmentCommand::
+redo(FlowScene &scene)
+{
+  scene.suspendPropagation();
+  scene.instantiateFragment(*_fragment, _offset, _nodeIds, _groupIds);
+  scene.resumePropagation();
+}
+
+
+QString
+FragmentCommand::
+name() const
+{
+  return _name;
+}
+
+
+std::size_t
+FragmentCommand::
+memoryUsage() const
+{
+  return sizeof(*this) +
+         (_nodeIds.capacity() + _groupIds.capacity()) * sizeof(QUuid) +
+         stringUsage(_name);
+}
+
+//------------------------------------------------------------------------------
+
+ConnectionCommand::
+ConnectionCommand(Kind kind,
+                  QUuid connectionId,
+                  QUuid nodeInId,
+                  PortIndex portIn,
+                  QUuid nodeOutId,
+                  PortIndex portOut)
+  : _kind(kind)
+  , _connectionId(connectionId)
+  , _nodeInId(nodeInId)
+  , _portIn(portIn)
+  , _nodeOutId(nodeOutId)
+  , _portOut(portOut)
+{}
+
+
+void
+ConnectionCommand::
+undo(FlowScene &scene)
+{
+  if (_kind == Kind::Added)
+    removeConnection(scene);
+  else
+    insertConnection(scene);
+}
+
+
+void
+ConnectionCommand::
+redo(FlowScene &scene)
+{
+  if (_kind == Kind::Added)
+    insertConnection(scene);
+  else
+    removeConnection(scene);
+}
+
+
+QString
+ConnectionCommand::
+name() const
+{
+  return (_kind == Kind::Added) ?
+         QStringLiteral("Created Connection ") :
+         QStringLiteral("Removed Connection ");
+}
+
+
+std::size_t
+ConnectionCommand::
+memoryUsage() const
+{
+  return sizeof(*this);
+}
+
+
+void
+ConnectionCommand::
+insertConnection(FlowScene &scene) const
+{
+  auto nodeIn  = scene.nodes().find(_nodeInId);
+  auto nodeOut = scene.nodes().find(_nodeOutId);
+
+  if (nodeIn == scene.nodes().end() || nodeOut == scene.nodes().end())
+    return;
+
+  QUuid id = _connectionId;
+  scene.createConnection(*nodeIn->second, _portIn,
+                         *nodeOut->second, _portOut,
+                         &id);
+}
+
+
+void
+ConnectionCommand::
+removeConnection(FlowScene &scene) const
+{
+  if (scene.connections().count(_connectionId))
+    scene.deleteConnectionWithID(_connectionId);
+}